@@ -3,7 +3,49 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <queue>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <array>
+#include <cctype>
+#include <climits>
+#include <tuple>
+#include <type_traits>
+#include <iterator>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <coroutine>
+#include <optional>
+#include <exception>
+#include <utility>
+#include <span>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
 
 using namespace std;
 
@@ -13,7 +55,7 @@ using namespace std;
  * Key Enhancements:
  * - Hash Table: O(1) course lookup instead of O(n) linear search
  * - Graph Structure: Adjacency list for prerequisite relationships and BFS traversal
- * - Merge Sort: Custom O(n log n) sorting with guaranteed performance vs stdout sort with worst case O(n^2) sorting
+ * - Merge Sort: Generic stable O(n log n) sorting, unlike std::sort which is O(n log n) but unstable
  */
 
 
@@ -22,12 +64,18 @@ using namespace std;
  * Course Structure
  *
  * Represents a single course with its number, name, and prerequisites.
+ *
+ * Requirements are kept in conjunctive form: every group must be satisfied, and a
+ * group is satisfied by any one of its courses ("MATH201 or MATH210"). When the
+ * groups are left empty, each entry of prerequisites is treated as its own group.
  */
 struct Course
 {
     string courseNumber; // Unique identifier for the course ("CS101")
     string name; // Full course name ("Introduction to Computer Science")
-    vector<string> prerequisites; // List of required prerequisite course numbers
+    vector<string> prerequisites; // Every course number mentioned by the prerequisite groups
+    vector<vector<string>> prerequisiteGroups; // Groups that must be completed beforehand
+    vector<vector<string>> corequisiteGroups; // Groups that may also be taken in the same semester
 };
 
 
@@ -38,6 +86,8 @@ struct Course
  *
  * Uses unordered_map internally for fast course retrieval by course number.
  * Implements case-insensitive searching to match original functionality.
+ * Courses are stored in a dense vector and addressed by record ID, so orderings
+ * can refer to them by index instead of copying them.
  *
  * Time Complexities:
  * - Insert: O(1) average case
@@ -46,7 +96,9 @@ struct Course
  */
 class CourseHashTable {
 private:
-    unordered_map<string, Course> courseMap;  // Internal hash table storage
+    unordered_map<string, size_t> courseMap;  // Internal hash table: course -> record ID
+    vector<Course> courseRecords; // Record ID -> course
+    vector<char> removedRecords; // Record ID -> 1 if the course was removed (IDs are never reused)
     
     /**
      * Convert string to lowercase for case-insensitive operations
@@ -61,11 +113,21 @@ private:
 public:
     /**
      * Insert a course into the hash table
+     *
+     * A course number already present (ignoring case) keeps its record ID, and so
+     * its place in record order, and takes the new definition.
+     *
      * @param course Course object to insert
      * Time Complexity: O(1) average case
      */
     void insert(const Course& course) {
-        courseMap[toLower(course.courseNumber)] = course;
+        auto inserted = courseMap.emplace(toLower(course.courseNumber), courseRecords.size());
+        if (inserted.second) {
+            courseRecords.push_back(course);
+            removedRecords.push_back(0);
+        } else {
+            courseRecords[inserted.first->second] = course;
+        }
     }
     
     /**
@@ -77,7 +139,7 @@ public:
     Course* find(const string& courseNumber) {
         string lowerKey = toLower(courseNumber);
         auto it = courseMap.find(lowerKey);
-        return (it != courseMap.end()) ? &it->second : nullptr;
+        return (it != courseMap.end()) ? &courseRecords[it->second] : nullptr;
     }
     
     /**
@@ -87,12 +149,72 @@ public:
      */
     vector<Course> getAllCourses() {
         vector<Course> courses;
-        for (const auto& pair : courseMap) {
-            courses.push_back(pair.second);
+        for (size_t id = 0; id < courseRecords.size(); id++) {
+            if (!removedRecords[id]) courses.push_back(courseRecords[id]);
         }
         return courses;
     }
     
+    /**
+     * Remove a course by course number
+     *
+     * The record ID is retired rather than reused, so orderings holding other IDs
+     * stay valid.
+     *
+     * @param courseNumber Course number to remove
+     * @return true if the course was found and removed
+     * Time Complexity: O(1) average case
+     */
+    bool erase(const string& courseNumber) {
+        auto it = courseMap.find(toLower(courseNumber));
+        if (it == courseMap.end()) {
+            return false;
+        }
+        
+        courseRecords[it->second] = Course();
+        removedRecords[it->second] = 1;
+        courseMap.erase(it);
+        return true;
+    }
+    
+    /**
+     * Get the record ID of a course
+     * @param courseNumber Course number to look up
+     * @return Record ID, or -1 if the course is not stored
+     * Time Complexity: O(1) average case
+     */
+    long recordId(const string& courseNumber) {
+        auto it = courseMap.find(toLower(courseNumber));
+        return (it != courseMap.end()) ? (long)it->second : -1;
+    }
+    
+    /**
+     * Check if a record ID belongs to a removed course
+     * @param id Record ID, less than recordCount()
+     * @return true if the course was removed
+     */
+    bool isRemoved(size_t id) const {
+        return removedRecords[id] != 0;
+    }
+    
+    /**
+     * Get a course by record ID
+     * @param id Record ID, less than recordCount()
+     * @return Reference to the stored course
+     * Time Complexity: O(1)
+     */
+    const Course& getCourse(size_t id) const {
+        return courseRecords[id];
+    }
+    
+    /**
+     * Get the number of record IDs in use, including removed courses
+     * @return Record count
+     */
+    size_t recordCount() const {
+        return courseRecords.size();
+    }
+    
     /**
      * Check if hash table is empty
      * @return true if empty, false otherwise
@@ -111,358 +233,9751 @@ public:
 };
 
 
+unsigned plannerThreadCount = 0; // Worker threads for parallel algorithms, 0 = one per hardware thread
+
+
 /**
- * Graph Data Structure for Prerequisite Relationships
+ * Get the number of worker threads parallel algorithms should use
+ * @return plannerThreadCount if set, otherwise the number of hardware threads
+ */
+unsigned workerCount()
+{
+    if (plannerThreadCount > 0) return plannerThreadCount;
+    return max(1u, thread::hardware_concurrency());
+}
+
+
+/**
+ * Run a loop body over [0, count) split into contiguous chunks across worker threads
  *
- * Enhancement: Implements adjacency list representation for complex prerequisite analysis
+ * Small loops run inline on the calling thread, since starting threads costs more
+ * than the work saved.
  *
- * Features:
- * - Adjacency List: Maps each course to its prerequisites
- * - Reverse List: Maps each course to courses that depend on it
- * - BFS Implementation: Find courses available after completing prerequisites
+ * @param count Number of loop iterations
+ * @param body Callback receiving a half-open [begin, end) chunk and the worker index
+ * @param minParallelCount Smallest count worth spreading across threads
+ * @return Number of workers the loop was split across
  */
-class PrerequisiteGraph {
+int parallelFor(size_t count, const function<void(size_t, size_t, int)>& body, size_t minParallelCount = 1 << 14)
+{
+    int workers = (int)workerCount();
+    if (count < minParallelCount || workers == 1) {
+        body(0, count, 0);
+        return 1;
+    }
+    
+    workers = (int)min<size_t>(workers, count);
+    size_t chunk = (count + workers - 1) / workers;
+    vector<thread> threads;
+    
+    for (int w = 1; w < workers; w++) {
+        size_t begin = min(count, w * chunk);
+        size_t end = min(count, begin + chunk);
+        threads.emplace_back(body, begin, end, w);
+    }
+    body(0, min(count, chunk), 0);
+    
+    for (thread& t : threads) {
+        t.join();
+    }
+    return workers;
+}
 
+
+/**
+ * Course Ordering
+ *
+ * A sorted view over the courses stored in a CourseHashTable, kept as a
+ * permutation of record IDs. Several orderings can share one catalog without
+ * copying any Course. A view is invalidated when its catalog is reloaded.
+ */
+class CourseOrdering {
 private:
-    unordered_map<string, list<string>> adjacencyList; // course -> its prerequisites
-    unordered_map<string, list<string>> reverseList; // course -> courses that depend on it
+    const CourseHashTable* catalog = nullptr; // Catalog the IDs refer to
+    vector<uint32_t> recordIds; // Record IDs in sorted order
+    
+public:
+    CourseOrdering() {}
     
     /**
-     * Convert string to lowercase for consistent key handling
-     * @param str Input string to convert
-     * @return Lowercase version of input string
+     * Create a view from a permutation of record IDs
+     * @param table Catalog holding the courses
+     * @param ids Record IDs in the desired order
      */
-    string toLower(string str) {
-        transform(str.begin(), str.end(), str.begin(), ::tolower);
-        return str;
+    CourseOrdering(const CourseHashTable& table, vector<uint32_t> ids) : catalog(&table), recordIds(move(ids)) {}
+    
+    /**
+     * Get the course at a position in the ordering
+     * @param position Index into the ordering
+     * @return Reference to the stored course
+     */
+    const Course& operator[](size_t position) const {
+        return catalog->getCourse(recordIds[position]);
     }
     
-public:
     /**
-     * Add a course and its prerequisite relationships to the graph
-     * @param course Course object containing prerequisite information
-     * Time Complexity: O(p) where p is number of prerequisites
+     * Get the underlying permutation
+     * @return Record IDs in sorted order
      */
-    void addCourse(const Course& course) {
-        string courseKey = toLower(course.courseNumber);
-        
-        adjacencyList[courseKey] = list<string>();
-        
-        for (const string& prereq : course.prerequisites) {
-            string prereqKey = toLower(prereq);
-            adjacencyList[courseKey].push_back(prereqKey);
-            reverseList[prereq].push_back(courseKey);
-        }
+    const vector<uint32_t>& ids() const {
+        return recordIds;
     }
     
     /**
-     * Find courses that become available after completing a given course
-     *
-     * Uses Breadth-First Search (BFS) to traverse prerequisite relationships
-     *
-     * @param completedCourse Course number that has been completed
-     * @param hashTable Reference to hash table for course lookup
-     * @return Vector of course numbers that become available
-     * Time Complexity: O(V + E) where V is courses, E is prerequisite relationships
+     * Get the number of courses in the view
+     * @return Course count
      */
-    vector<string> findAvailableCourses(const string& completedCourse, const CourseHashTable& hashTable) {
-        vector<string> available;
-        string courseKey = toLower(completedCourse);
-        
-        if(reverseList.find(courseKey) == reverseList.end()) {
-            return available;
-        }
-        
-        queue<string> q;
-        unordered_map<string, bool> visited;
-        
-        for(const string& dependent : reverseList[courseKey]) {
-            q.push(dependent);
-        }
-        
-        while (!q.empty()) {
-            string current = q.front();
-            q.pop();
-            
-            if(visited[current]) continue;
-            visited[current] = true;
-            
-            bool allPrereqsMet = true;
-            for(const string& prereq : adjacencyList[current]) {
-                if(toLower(prereq) != courseKey) {
-                    allPrereqsMet = false;
-                    break;
-                }
-            }
-            
-            if(allPrereqsMet) {
-                available.push_back(current);
-                
-                if(reverseList.find(current) != reverseList.end()) {
-                    for(const string& next : reverseList[current]) {
-                        if(!visited[next]) {
-                            q.push(next);
-                        }
-                    }
-                }
-            }
-        }
-        
-        return available;
+    size_t size() const {
+        return recordIds.size();
     }
     
     /**
-     * Get prerequisites for a specific course
-     * @param courseNumber Course to get prerequisites for
-     * @return List of prerequisite course numbers
+     * Check if the view is empty
+     * @return true if empty, false otherwise
      */
-    list<string> getPrerequisites(const string& courseNumber) {
-        string courseKey = toLower(courseNumber);
-        return adjacencyList[courseKey];
+    bool empty() const {
+        return recordIds.empty();
     }
 };
 
 
 /**
- * Custom Merge Sort Implementation
+ * Sort Key Structure
  *
- * Enhancement: Replaces std::sort with guaranteed O(n log n) performance
- *
- * - Guaranteed O(n log n) time complexity in all cases
- * - Stable sorting (maintains relative order of equal elements)
- * - Predictable performance regardless of input data distribution
+ * Compact (key, record ID) pair sorted in place of whole Course objects.
+ */
+struct CourseSortKey
+{
+    uint64_t key; // Precomputed key; ties fall back to the full comparison
+    uint32_t id; // Record ID of the course
+};
+
+
+/**
+ * Direction of a traversal over the prerequisite graph
+ */
+enum class TraversalDirection {
+    Dependents, // Follow course -> courses that require it
+    Ancestors // Follow course -> its prerequisites
+};
+
+
+/**
+ * Course Bitset
  *
- * std::sort typically uses introsort which can degrade to O(n²) in worst case,
- * while merge sort maintains consistent O(n log n) performance.
+ * Set of course IDs stored one bit per course, used for transcripts and
+ * co-requisite enrollments when evaluating compiled requirements.
  */
-class MergeSort {
+class CourseBitset {
+private:
+    vector<uint64_t> words; // Bit i of words[i / 64] is set if course i is in the set
+    
 public:
     /**
-     * Public interface for merge sort
-     * @param courses Vector of courses to sort
-     * @param left Starting index
-     * @param right Ending index
-     * Time Complexity: O(n log n) guaranteed
-     * Space Complexity: O(n) for temporary arrays
+     * Create an empty set able to hold the given number of course IDs
+     * @param courseCount Number of course IDs
      */
-    static void mergeSort(vector<Course>& courses, int left, int right) {
-        if(left < right) {
-            int mid = left + (right - left) / 2;
-            
-            mergeSort(courses, left, mid);
-            mergeSort(courses, mid + 1, right);
-            
-            merge(courses, left, mid, right);
+    explicit CourseBitset(size_t courseCount = 0) : words((courseCount + 63) / 64, 0) {}
+    
+    /**
+     * Add a course ID to the set, growing it if needed
+     * @param id Course ID to add
+     */
+    void set(int id) {
+        if((size_t)id / 64 >= words.size()) {
+            words.resize(id / 64 + 1, 0);
         }
+        words[id / 64] |= 1ULL << (id % 64);
     }
     
-private:
     /**
-     * Merge two sorted subarrays into a single sorted array
-     * @param courses Vector containing the subarrays to merge
-     * @param left Starting index of left subarray
-     * @param mid Ending index of left subarray
-     * @param right Ending index of right subarray
+     * Check if a course ID is in the set
+     * @param id Course ID to check
+     * @return true if present, false otherwise
      */
-    static void merge(vector<Course>& courses, int left, int mid, int right) {
-        int n1 = mid - left + 1;
-        int n2 = right - mid;
-        
-        vector<Course> leftArray(n1);
-        vector<Course> rightArray(n2);
-        
-        for(int i = 0; i < n1; i++) {
-            leftArray[i] = courses[left + i];
-        }
-        for(int j = 0; j < n2; j++) {
-            rightArray[j] = courses[mid + 1 + j];
-        }
-        
-        int i = 0, j = 0, k = left;
-        
-        while (i < n1 && j < n2) {
-            if(leftArray[i].courseNumber <= rightArray[j].courseNumber) {
-                courses[k] = leftArray[i];
-                i++;
-            } else {
-                courses[k] = rightArray[j];
-                j++;
-            }
-            k++;
-        }
-        
-        while(i <n1) {
-            courses[k] = leftArray[i];
-            i++;
-            k++;
-        }
-        
-        while(j < n2) {
-            courses[k] = rightArray[j];
-            j++;
-            k++;
+    bool test(int id) const {
+        return (size_t)id / 64 < words.size() && (words[id / 64] >> (id % 64)) & 1;
+    }
+    
+    /**
+     * Remove a course ID from the set
+     * @param id Course ID to remove
+     */
+    void reset(int id) {
+        if((size_t)id / 64 < words.size()) {
+            words[id / 64] &= ~(1ULL << (id % 64));
         }
     }
+    
+    /**
+     * Get the raw 64-bit words of the set
+     * @return Pointer to the first word
+     */
+    const uint64_t* data() const {
+        return words.data();
+    }
+    
+    /**
+     * Get the number of 64-bit words in the set
+     * @return Word count
+     */
+    size_t wordCount() const {
+        return words.size();
+    }
 };
 
 
-// Global data structures
-CourseHashTable courseHashTable; // Hash table for O(1) course lookup
-PrerequisiteGraph prereqGraph; // Graph for prerequisite relationships
-bool dataLoaded = false; // Flag to track if courses are loaded
-
-
 /**
- * Parse a comma-separated string into a vector of strings
+ * Compiled Requirement Instruction
  *
- * @param s Input string to parse
- * @param del Delimiter to split on (default: comma)
- * @return Vector of parsed string tokens
+ * One step of a course's compiled prerequisite program. Each instruction tests a
+ * single 64-bit word of the student's completed-course bitset against a mask.
  */
-vector<string> format(const string s, const string del = ",")
+struct RequirementOp
 {
-    vector<string> result;
-    size_t start = 0, end = s.find(del);
-    while( end != string::npos)
-    {
-        result.push_back(s.substr(start, end - start));
-        start = end + del.size();
-        end = s.find(del, start);
-    }
-    result.push_back(s.substr(start, end - start));
-    return result;
-}
+    static const uint32_t ANY = 1; // Satisfied by any bit in mask (default: all bits required)
+    static const uint32_t END_GROUP = 2; // Last instruction of an ANY group
+    static const uint32_t COREQUISITE = 4; // Courses currently enrolled in also count
+    
+    uint32_t word; // Index of the bitset word to test
+    uint32_t flags; // Combination of the flags above
+    uint64_t mask; // Course bits tested within the word
+};
 
 
 /**
- * Load courses from file and populate  data structures
- *
- * Enhancements:
- * 1. Populates hash table for O(1) lookups
- * 2. Builds prerequisite graph for relationship analysis
- * 3. Sorts array using custom merge sort
+ * Eligibility Matrix
  *
- * @return Vector of loaded courses
- * Time Complexity: O(n log n) due to sorting
+ * Result of a bulk eligibility run: which students may take which courses.
+ * Stored course-major, one bitset over students per course, which is the layout
+ * the bulk evaluation produces with whole-word operations.
  */
-vector<Course> loadCoursesFile()
-{
-    ifstream fin("courses.txt", ios::in);
-    vector<Course> courses;
-    string line;
-    bool entered = false;
+class EligibilityMatrix {
+private:
+    size_t studentCount = 0; // Number of students (columns)
+    size_t studentWords = 0; // 64-bit words per course row
+    vector<uint64_t> bits; // Row for course ID c starts at bits[c * studentWords]
     
-    // Clear existing data structure
-    courseHashTable = CourseHashTable();
-    prereqGraph = PrerequisiteGraph();
-
-    while (getline(fin, line))
-    {
-        if(line == "-1") break;
-        entered = true;
-
-        Course course;
-        vector<string> info = format(line);
-
-        course.courseNumber = info[0];
-        course.name = info[1];
-
-        for(int i = 2; i < info.size(); i++)
-        {
-            course.prerequisites.push_back(info[i]);
-        }
-
-        courses.push_back(course);
-        
-        courseHashTable.insert(course);
-        prereqGraph.addCourse(course);
+public:
+    /**
+     * Create an all-false matrix
+     * @param courseCount Number of course IDs (rows)
+     * @param students Number of students (columns)
+     */
+    EligibilityMatrix(size_t courseCount = 0, size_t students = 0)
+        : studentCount(students), studentWords((students + 63) / 64), bits(courseCount * studentWords, 0) {}
+    
+    /**
+     * Get the row of student bits for one course
+     * @param courseId Course ID
+     * @return Pointer to the course's studentWords() words
+     */
+    uint64_t* row(int courseId) {
+        return &bits[(size_t)courseId * studentWords];
     }
     
-    // If the while loop was never entered, this means the file was never read.
-    // If it was entered but the vector is empty, the file is empty.
-    if (!entered) {
-            std::cout << "Could not access courses file. Please check if loaded properly." << endl;
+    const uint64_t* row(int courseId) const {
+        return &bits[(size_t)courseId * studentWords];
+    }
+    
+    /**
+     * Check if a student may take a course
+     * @param student Student index in the transcript list
+     * @param courseId Course ID
+     * @return true if eligible
+     */
+    bool isEligible(size_t student, int courseId) const {
+        return (row(courseId)[student / 64] >> (student % 64)) & 1;
+    }
+    
+    /**
+     * Count the students eligible for a course
+     * @param courseId Course ID
+     * @return Number of eligible students
+     */
+    size_t countEligible(int courseId) const {
+        size_t count = 0;
+        const uint64_t* words = row(courseId);
+        for(size_t w = 0; w < studentWords; w++) {
+            count += __builtin_popcountll(words[w]);
+        }
+        return count;
+    }
+    
+    /**
+     * Get the number of students in the matrix
+     * @return Student count
+     */
+    size_t students() const {
+        return studentCount;
+    }
+    
+    /**
+     * Get the number of 64-bit words in each course row
+     * @return Words per row
+     */
+    size_t wordsPerRow() const {
+        return studentWords;
+    }
+};
+
+
+/**
+ * Strategy for relabeling course IDs to improve traversal cache locality
+ */
+enum class ReorderStrategy {
+    ReverseCuthillMcKee, // BFS from low-degree courses, reversed, so neighbours get nearby IDs
+    DepartmentLevel // Group by department, then by level, then by course number
+};
+
+
+/**
+ * Prerequisite Edges in Compressed Sparse Row Form
+ *
+ * Read-only view of a prerequisite graph's edges over integer course IDs, which
+ * is all a k-hop search needs. The arrays may belong to a PrerequisiteGraph or to
+ * a catalog mapped from elsewhere.
+ */
+struct CsrGraphView
+{
+    const int* prerequisiteOffsets = nullptr; // Prerequisites of ID i are prerequisiteTargets[offsets[i] .. offsets[i + 1])
+    const int* prerequisiteTargets = nullptr;
+    const int* dependentOffsets = nullptr; // Dependents of ID i, laid out the same way
+    const int* dependentTargets = nullptr;
+    size_t courseCount = 0; // Number of course IDs
+};
+
+
+/**
+ * Compiled Requirement Programs
+ *
+ * Read-only view of every course's compiled requirement program, as built by a
+ * PrerequisiteGraph or mapped from a catalog image.
+ */
+struct RequirementProgramView
+{
+    const RequirementOp* ops = nullptr; // Programs of all courses, back to back
+    const int* offsets = nullptr; // Program of ID i is ops[offsets[i] .. offsets[i + 1])
+    size_t courseCount = 0; // Number of course IDs
+};
+
+
+/**
+ * Impact Report Structure
+ *
+ * Lists every course transitively blocked when a course is cancelled.
+ */
+struct ImpactReport
+{
+    string courseNumber; // Course that was cancelled or cut
+    vector<string> blockedCourses; // Courses that (transitively) require it, nearest first
+    size_t blockedCount = 0; // Number of blocked courses
+};
+
+
+/**
+ * Graph Data Structure for Prerequisite Relationships
+ *
+ * Enhancement: Implements adjacency list representation for complex prerequisite analysis
+ *
+ * Features:
+ * - Adjacency List: Maps each course to its prerequisites
+ * - Reverse List: Maps each course to courses that depend on it
+ * - BFS Implementation: Find courses available after completing prerequisites
+ * - Course Levels: Cached longest-path depth of every course in the prerequisite DAG
+ * - K-Hop Queries: Direction-optimizing parallel BFS over integer IDs in CSR form
+ * - Impact Analysis: Transitive dependents of one course, or descendant counts for all courses
+ * - Compiled Requirements: AND/OR prerequisite and co-requisite groups evaluated as bitmask programs
+ * - Live Edits: Pearce-Kelly maintenance of the topological order and levels, rejecting cycles
+ * - ID Reordering: Optional relabeling pass so related courses sit close together in memory
+ * - Bulk Eligibility: Whole-cohort students x courses matrix from bit-sliced transcripts
+ */
+class PrerequisiteGraph {
+
+private:
+    unordered_map<string, list<string>> adjacencyList; // course -> its prerequisites
+    unordered_map<string, list<string>> reverseList; // course -> courses that depend on it
+    
+    unordered_map<string, int> courseIds; // course -> dense integer ID
+    vector<string> courseKeys; // integer ID -> course
+    vector<vector<int>> prerequisiteIds; // integer ID -> IDs of its prerequisites
+    vector<vector<int>> dependentIds; // integer ID -> IDs of courses that depend on it
+    vector<vector<vector<int>>> prerequisiteGroupIds; // integer ID -> AND of OR-groups of prerequisite IDs
+    vector<vector<vector<int>>> corequisiteGroupIds; // integer ID -> AND of OR-groups of co-requisite IDs
+    
+    vector<int> topologicalOrder; // Cached: IDs ordered so prerequisites come before dependents
+    vector<int> topologicalPosition; // Cached: ID -> index in topologicalOrder (-1 if on a cycle)
+    vector<int> courseLevels; // Cached: ID -> minimum number of semesters to complete (0 if a cycle blocks it)
+    bool levelsValid = false; // Flag to track if the cached levels reflect the current graph
+    bool rejectCycles = false; // Set once levels are first computed; addCourse then refuses cycles
+    vector<char> searchMarks; // Scratch marks for bounded searches, all zero between calls
+    vector<int> levelChanges; // IDs whose level changed since the last takeLevelChanges call
+    bool levelChangesComplete = true; // false once levels were recomputed wholesale since that call
+    
+    // Compressed sparse row copies of prerequisiteIds/dependentIds for traversals
+    vector<int> prerequisiteOffsets, prerequisiteTargets;
+    vector<int> dependentOffsets, dependentTargets;
+    bool csrValid = false; // Flag to track if the CSR arrays reflect the current graph
+    
+    vector<int> descendantCounts; // Cached: ID -> number of courses that transitively require it
+    bool descendantCountsValid = false; // Flag to track if the cached counts reflect the current graph
+    
+    vector<RequirementOp> requirementOps; // Compiled requirement programs of all courses, back to back
+    vector<int> requirementOffsets; // Program of ID i is requirementOps[offsets[i] .. offsets[i + 1])
+    bool requirementsValid = false; // Flag to track if the compiled programs reflect the current graph
+    
+    friend class CatalogImage; // Flattens the cached arrays into a shared image
+    
+    /**
+     * Convert string to lowercase for consistent key handling
+     * @param str Input string to convert
+     * @return Lowercase version of input string
+     */
+    static string toLower(string str) {
+        transform(str.begin(), str.end(), str.begin(), ::tolower);
+        return str;
+    }
+    
+    /**
+     * Get the integer ID of a course, assigning the next free ID if it is new
+     * @param courseKey Lowercase course number
+     * @return Dense integer ID of the course
+     * Time Complexity: O(1) average case
+     */
+    int internCourse(const string& courseKey) {
+        auto it = courseIds.find(courseKey);
+        if(it != courseIds.end()) {
+            return it->second;
+        }
+        
+        int id = (int)courseKeys.size();
+        courseIds[courseKey] = id;
+        courseKeys.push_back(courseKey);
+        prerequisiteIds.emplace_back();
+        dependentIds.emplace_back();
+        prerequisiteGroupIds.emplace_back();
+        corequisiteGroupIds.emplace_back();
+        searchMarks.push_back(0);
+        
+        // A new course has no edges yet, so it can go last in a maintained order
+        if(levelsValid) {
+            topologicalPosition.push_back((int)topologicalOrder.size());
+            topologicalOrder.push_back(id);
+            courseLevels.push_back(1);
+        }
+        return id;
+    }
+    
+    /**
+     * Check if the cached topological order covers every course and can be updated in place
+     * @return true if levels are cached and the graph is acyclic
+     */
+    bool orderMaintained() const {
+        return levelsValid && topologicalOrder.size() == courseKeys.size();
+    }
+    
+    /**
+     * Add a prerequisite edge to the adjacency structures if it is not already present
+     * @param courseId Course that requires the prerequisite
+     * @param prereqId Prerequisite course
+     */
+    void linkPrerequisite(int courseId, int prereqId) {
+        vector<int>& prereqs = prerequisiteIds[courseId];
+        if(find(prereqs.begin(), prereqs.end(), prereqId) != prereqs.end()) return;
+        
+        adjacencyList[courseKeys[courseId]].push_back(courseKeys[prereqId]);
+        reverseList[courseKeys[prereqId]].push_back(courseKeys[courseId]);
+        prereqs.push_back(prereqId);
+        dependentIds[prereqId].push_back(courseId);
+    }
+    
+    /**
+     * Remove a prerequisite edge from the adjacency structures
+     * @param courseId Course that requires the prerequisite
+     * @param prereqId Prerequisite course
+     */
+    void unlinkPrerequisite(int courseId, int prereqId) {
+        vector<int>& prereqs = prerequisiteIds[courseId];
+        prereqs.erase(remove(prereqs.begin(), prereqs.end(), prereqId), prereqs.end());
+        vector<int>& dependents = dependentIds[prereqId];
+        dependents.erase(remove(dependents.begin(), dependents.end(), courseId), dependents.end());
+        
+        auto adjacent = adjacencyList.find(courseKeys[courseId]);
+        if(adjacent != adjacencyList.end()) adjacent->second.remove(courseKeys[prereqId]);
+        auto reverse = reverseList.find(courseKeys[prereqId]);
+        if(reverse != reverseList.end()) reverse->second.remove(courseKeys[courseId]);
+    }
+    
+    /**
+     * Depth-first search along dependent edges for any of a set of courses
+     *
+     * With a maintained order, only courses positioned at or before maxPosition can
+     * lie on a path to the targets, so the search never leaves that region.
+     *
+     * @param startId Course to search from
+     * @param targets Courses to look for
+     * @param maxPosition Highest topological position to visit, negative for unbounded
+     * @param visitedIds Output: every course visited, in visiting order
+     * @return true if any target is reachable from startId
+     */
+    bool searchDependents(int startId, const vector<int>& targets, int maxPosition, vector<int>& visitedIds) {
+        bool found = false;
+        vector<int> stack(1, startId);
+        searchMarks[startId] = 1;
+        
+        while(!stack.empty() && !found) {
+            int current = stack.back();
+            stack.pop_back();
+            visitedIds.push_back(current);
+            
+            for(int dependent : dependentIds[current]) {
+                if(find(targets.begin(), targets.end(), dependent) != targets.end()) {
+                    found = true;
+                    break;
+                }
+                if(searchMarks[dependent]) continue;
+                if(maxPosition >= 0 && topologicalPosition[dependent] > maxPosition) continue;
+                searchMarks[dependent] = 1;
+                stack.push_back(dependent);
+            }
+        }
+        
+        for(int id : stack) searchMarks[id] = 0;
+        for(int id : visitedIds) searchMarks[id] = 0;
+        return found;
+    }
+    
+    /**
+     * Check if making a course require any of the given prerequisites would close a cycle
+     * @param courseId Course gaining prerequisites
+     * @param prereqIds Prerequisites being added
+     * @return true if a prerequisite is the course itself or one of its transitive dependents
+     * Time Complexity: O(affected region) with a maintained order, O(V + E) otherwise
+     */
+    bool createsCycle(int courseId, const vector<int>& prereqIds) {
+        if(prereqIds.empty()) return false;
+        if(find(prereqIds.begin(), prereqIds.end(), courseId) != prereqIds.end()) return true;
+        
+        int maxPosition = -1;
+        if(orderMaintained()) {
+            for(int prereqId : prereqIds) {
+                maxPosition = max(maxPosition, topologicalPosition[prereqId]);
+            }
+            // Every prerequisite already precedes the course, so none can depend on it
+            if(maxPosition < topologicalPosition[courseId]) return false;
+        }
+        
+        vector<int> visitedIds;
+        return searchDependents(courseId, prereqIds, maxPosition, visitedIds);
+    }
+    
+    /**
+     * Restore the topological order after adding the edge prereqId -> courseId (Pearce-Kelly)
+     *
+     * Only courses positioned between the two endpoints can be out of order. Those
+     * reachable forward from the course and backward from the prerequisite are
+     * collected, then the backward set is placed before the forward set within the
+     * same pool of positions. The edge must not close a cycle.
+     *
+     * @param courseId Course that gained the prerequisite
+     * @param prereqId New prerequisite
+     * Time Complexity: O(affected region log affected region)
+     */
+    void reorderForEdge(int courseId, int prereqId) {
+        int lower = topologicalPosition[courseId];
+        int upper = topologicalPosition[prereqId];
+        if(upper < lower) return;
+        
+        vector<int> forwardIds;
+        searchDependents(courseId, vector<int>(), upper, forwardIds);
+        
+        vector<int> backwardIds;
+        vector<int> stack(1, prereqId);
+        searchMarks[prereqId] = 1;
+        while(!stack.empty()) {
+            int current = stack.back();
+            stack.pop_back();
+            backwardIds.push_back(current);
+            for(int prereq : prerequisiteIds[current]) {
+                if(searchMarks[prereq] || topologicalPosition[prereq] < lower) continue;
+                searchMarks[prereq] = 1;
+                stack.push_back(prereq);
+            }
+        }
+        for(int id : backwardIds) searchMarks[id] = 0;
+        
+        auto byPosition = [this](int a, int b) { return topologicalPosition[a] < topologicalPosition[b]; };
+        sort(forwardIds.begin(), forwardIds.end(), byPosition);
+        sort(backwardIds.begin(), backwardIds.end(), byPosition);
+        
+        vector<int> moved = backwardIds;
+        moved.insert(moved.end(), forwardIds.begin(), forwardIds.end());
+        vector<int> positions;
+        for(int id : moved) positions.push_back(topologicalPosition[id]);
+        sort(positions.begin(), positions.end());
+        
+        for(size_t i = 0; i < moved.size(); i++) {
+            topologicalPosition[moved[i]] = positions[i];
+            topologicalOrder[positions[i]] = moved[i];
+        }
+    }
+    
+    /**
+     * Recompute the levels of some courses and of every dependent whose level changes
+     *
+     * Courses are visited in topological order from a min-heap, so each one sees its
+     * prerequisites' final levels; propagation stops wherever a level is unchanged.
+     *
+     * @param startIds Courses whose prerequisites changed
+     * Time Complexity: O(affected region log affected region)
+     */
+    void propagateLevels(const vector<int>& startIds) {
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pending;
+        vector<int> queued;
+        for(int id : startIds) {
+            if(searchMarks[id]) continue;
+            searchMarks[id] = 1;
+            queued.push_back(id);
+            pending.emplace(topologicalPosition[id], id);
+        }
+        
+        while(!pending.empty()) {
+            int current = pending.top().second;
+            pending.pop();
+            
+            int level = levelFromPrerequisites(current);
+            if(level == courseLevels[current]) continue;
+            courseLevels[current] = level;
+            levelChanges.push_back(current);
+            
+            for(int dependent : dependentIds[current]) {
+                if(searchMarks[dependent]) continue;
+                searchMarks[dependent] = 1;
+                queued.push_back(dependent);
+                pending.emplace(topologicalPosition[dependent], dependent);
+            }
+        }
+        for(int id : queued) searchMarks[id] = 0;
+    }
+    
+    /**
+     * Replace the prerequisite groups of a course, keeping the cached order and levels current
+     * @param courseId Course to update
+     * @param groups New prerequisite groups, known not to close a cycle when the order is maintained
+     */
+    void setPrerequisiteGroups(int courseId, const vector<vector<int>>& groups) {
+        vector<int> oldPrereqs = prerequisiteIds[courseId];
+        for(int prereqId : oldPrereqs) {
+            unlinkPrerequisite(courseId, prereqId);
+        }
+        
+        bool maintained = orderMaintained();
+        prerequisiteGroupIds[courseId] = groups;
+        for(const vector<int>& group : groups) {
+            for(int prereqId : group) {
+                linkPrerequisite(courseId, prereqId);
+                if(maintained) reorderForEdge(courseId, prereqId);
+            }
+        }
+        
+        if(maintained) {
+            propagateLevels(vector<int>(1, courseId));
+        } else {
+            levelsValid = false;
+        }
+        csrValid = false;
+        descendantCountsValid = false;
+        requirementsValid = false;
+    }
+    
+    /**
+     * Intern every course of a list of requirement groups
+     * @param groups Groups of course numbers
+     * @return The same groups as integer IDs
+     */
+    vector<vector<int>> internGroups(const vector<vector<string>>& groups) {
+        vector<vector<int>> idGroups;
+        for(const vector<string>& group : groups) {
+            vector<int> ids;
+            for(const string& alternative : group) {
+                ids.push_back(internCourse(toLower(alternative)));
+            }
+            if(!ids.empty()) {
+                idGroups.push_back(ids);
+            }
+        }
+        return idGroups;
+    }
+    
+    /**
+     * Compute the level of a course from the cached levels of its prerequisites
+     *
+     * Each group costs as much as its shallowest alternative; the course is taken
+     * the semester after its deepest group.
+     *
+     * @param id Course ID whose prerequisites already have levels
+     * @return Level of the course
+     */
+    int levelFromPrerequisites(int id) const {
+        int deepest = 0;
+        for(const vector<int>& group : prerequisiteGroupIds[id]) {
+            int shallowest = courseLevels[group[0]];
+            for(int alternative : group) {
+                shallowest = min(shallowest, courseLevels[alternative]);
+            }
+            deepest = max(deepest, shallowest);
+        }
+        return deepest + 1;
+    }
+    
+    /**
+     * Append the instructions testing a list of requirement groups to a program
+     *
+     * Single-course groups are merged per bitset word into one all-bits test; each
+     * OR-group becomes a run of any-bit tests, one per word it touches.
+     *
+     * @param groups Requirement groups as integer IDs
+     * @param extraFlags Flags added to every instruction (COREQUISITE or 0)
+     * @param program Output: instruction list to append to
+     */
+    static void compileGroups(const vector<vector<int>>& groups, uint32_t extraFlags, vector<RequirementOp>& program) {
+        vector<pair<uint32_t, uint64_t>> required;
+        for(const vector<int>& group : groups) {
+            if(group.size() == 1) {
+                required.emplace_back(group[0] / 64, 1ULL << (group[0] % 64));
+            }
+        }
+        sort(required.begin(), required.end());
+        for(size_t i = 0; i < required.size(); i++) {
+            if(i > 0 && required[i - 1].first == required[i].first) {
+                program.back().mask |= required[i].second;
+            } else {
+                program.push_back({required[i].first, extraFlags, required[i].second});
+            }
+        }
+        
+        for(const vector<int>& group : groups) {
+            if(group.size() == 1) continue;
+            
+            vector<pair<uint32_t, uint64_t>> alternatives;
+            for(int id : group) {
+                alternatives.emplace_back(id / 64, 1ULL << (id % 64));
+            }
+            sort(alternatives.begin(), alternatives.end());
+            for(size_t i = 0; i < alternatives.size(); i++) {
+                if(i > 0 && alternatives[i - 1].first == alternatives[i].first) {
+                    program.back().mask |= alternatives[i].second;
+                } else {
+                    program.push_back({alternatives[i].first, RequirementOp::ANY | extraFlags, alternatives[i].second});
+                }
+            }
+            program.back().flags |= RequirementOp::END_GROUP;
+        }
+    }
+    
+    /**
+     * Compile the requirements of every course into flat bitmask programs
+     * Time Complexity: O(V + E log E)
+     */
+    void compileRequirements() {
+        size_t n = courseKeys.size();
+        requirementOps.clear();
+        requirementOffsets.assign(n + 1, 0);
+        
+        for(size_t id = 0; id < n; id++) {
+            compileGroups(prerequisiteGroupIds[id], 0, requirementOps);
+            compileGroups(corequisiteGroupIds[id], RequirementOp::COREQUISITE, requirementOps);
+            requirementOffsets[id + 1] = (int)requirementOps.size();
+        }
+        requirementsValid = true;
+    }
+    
+    /**
+     * Run the compiled program of one course against a transcript
+     * @param id Course ID to evaluate
+     * @param completed Courses already completed
+     * @param enrolled Courses being taken this semester (co-requisites only), may be null
+     * @return true if every requirement group is satisfied
+     * Time Complexity: O(instructions), typically a handful of word tests
+     */
+    bool evaluateRequirements(int id, const CourseBitset& completed, const CourseBitset* enrolled) const {
+        return evaluateProgram(requirementOps.data() + requirementOffsets[id], requirementOps.data() + requirementOffsets[id + 1],
+                               completed, enrolled);
+    }
+    
+    /**
+     * Flatten an adjacency vector into compressed sparse row offsets and targets
+     * @param adjacency Neighbour lists indexed by course ID
+     * @param offsets Output: neighbours of ID i are targets[offsets[i] .. offsets[i + 1])
+     * @param targets Output: concatenated neighbour lists
+     */
+    static void buildCsr(const vector<vector<int>>& adjacency, vector<int>& offsets, vector<int>& targets) {
+        offsets.assign(adjacency.size() + 1, 0);
+        for(size_t id = 0; id < adjacency.size(); id++) {
+            offsets[id + 1] = offsets[id] + (int)adjacency[id].size();
+        }
+        
+        targets.resize(offsets.back());
+        for(size_t id = 0; id < adjacency.size(); id++) {
+            copy(adjacency[id].begin(), adjacency[id].end(), targets.begin() + offsets[id]);
+        }
+    }
+    
+    /**
+     * Rebuild the CSR arrays if the graph changed since they were last built
+     * Time Complexity: O(V + E) when rebuilding, O(1) otherwise
+     */
+    void ensureCsr() {
+        if(csrValid) return;
+        buildCsr(prerequisiteIds, prerequisiteOffsets, prerequisiteTargets);
+        buildCsr(dependentIds, dependentOffsets, dependentTargets);
+        csrValid = true;
+    }
+    
+    /**
+     * Get the CSR arrays as a view for searches
+     */
+    CsrGraphView csrView() {
+        ensureCsr();
+        return {prerequisiteOffsets.data(), prerequisiteTargets.data(),
+                dependentOffsets.data(), dependentTargets.data(), courseKeys.size()};
+    }
+    
+    /**
+     * Breadth-first search progress between hops
+     */
+    struct BfsState {
+        CsrGraphView edges; // Graph being searched
+        bool forward = true; // Whether dependent edges are followed
+        int maxHops = -1; // Maximum distance to explore, negative for unlimited
+        int hop = 0; // Hops expanded so far
+        bool bottomUp = false; // Whether the last hop was expanded bottom-up
+        long long unexploredEdges = 0; // Outgoing edges not yet expanded
+        unique_ptr<atomic<uint64_t>[]> visited; // One bit per claimed course ID
+        vector<int> frontier; // IDs reached by the last hop, sorted
+        vector<int> reached; // Reached IDs, sorted by hop distance then ID
+        vector<int> hopStarts; // reached[hopStarts[h - 1] .. hopStarts[h]) are h hops away
+    };
+    
+    /**
+     * Set up a breadth-first search from a single course
+     * @param edges Graph to search
+     * @param sourceId ID to start from (not included in the result)
+     * @param direction Whether to follow dependent or prerequisite edges
+     * @param maxHops Maximum distance to explore, negative for unlimited
+     * @param state Output: search positioned before its first hop
+     */
+    static void startBfs(const CsrGraphView& edges, int sourceId, TraversalDirection direction, int maxHops, BfsState& state) {
+        state.edges = edges;
+        state.forward = direction == TraversalDirection::Dependents;
+        state.maxHops = maxHops;
+        state.hop = 0;
+        state.bottomUp = false;
+        const int* outOffsets = state.forward ? edges.dependentOffsets : edges.prerequisiteOffsets;
+        state.unexploredEdges = outOffsets[edges.courseCount];
+        
+        size_t words = (edges.courseCount + 63) / 64;
+        state.visited.reset(new atomic<uint64_t>[words]);
+        for(size_t w = 0; w < words; w++) state.visited[w].store(0, memory_order_relaxed);
+        state.visited[sourceId / 64].fetch_or(1ULL << (sourceId % 64), memory_order_relaxed);
+        
+        state.frontier.assign(1, sourceId);
+        state.reached.clear();
+        state.hopStarts.assign(1, 0);
+    }
+    
+    /**
+     * Expand one hop of a breadth-first search
+     *
+     * Follows Beamer's hybrid BFS. Top-down steps expand the frontier list and claim
+     * neighbours in an atomic visited bitmap. When the frontier's outgoing edges
+     * exceed 1/ALPHA of the edges left unexplored, steps switch to bottom-up: every
+     * unvisited course scans its incoming edges for a parent in the frontier bitmap
+     * and stops at the first hit. Once the frontier shrinks below 1/BETA of the
+     * courses, steps switch back to top-down. Both kinds of step are split across
+     * threads by parallelFor.
+     *
+     * @param state Search to advance
+     * @return false, without doing anything, once the search is finished
+     * Time Complexity: O(V + E) work over a whole search, O(D) parallel steps for a graph of depth D
+     */
+    static bool expandHop(BfsState& state) {
+        const int ALPHA = 14;
+        const int BETA = 24;
+        
+        if(state.frontier.empty() || (state.maxHops >= 0 && state.hop >= state.maxHops)) {
+            return false;
+        }
+        state.hop++;
+        
+        const CsrGraphView& edges = state.edges;
+        const int* outOffsets = state.forward ? edges.dependentOffsets : edges.prerequisiteOffsets;
+        const int* outTargets = state.forward ? edges.dependentTargets : edges.prerequisiteTargets;
+        const int* inOffsets = state.forward ? edges.prerequisiteOffsets : edges.dependentOffsets;
+        const int* inTargets = state.forward ? edges.prerequisiteTargets : edges.dependentTargets;
+        
+        size_t n = edges.courseCount;
+        size_t words = (n + 63) / 64;
+        atomic<uint64_t>* visited = state.visited.get();
+        vector<int>& frontier = state.frontier;
+        
+        long long frontierEdges = 0;
+        for(int id : frontier) {
+            frontierEdges += outOffsets[id + 1] - outOffsets[id];
+        }
+        state.unexploredEdges -= frontierEdges;
+        
+        if(!state.bottomUp && frontierEdges > state.unexploredEdges / ALPHA) {
+            state.bottomUp = true;
+        } else if(state.bottomUp && frontier.size() < n / BETA) {
+            state.bottomUp = false;
+        }
+        
+        vector<vector<int>> localNext(workerCount());
+        
+        if(state.bottomUp) {
+            vector<uint64_t> frontierBits(words, 0);
+            for(int id : frontier) {
+                frontierBits[id / 64] |= 1ULL << (id % 64);
+            }
+            
+            // Chunks are whole bitmap words, so each worker owns the visited words it writes
+            parallelFor(words, [&](size_t begin, size_t end, int worker) {
+                vector<int>& next = localNext[worker];
+                for(size_t w = begin; w < end; w++) {
+                    uint64_t seen = visited[w].load(memory_order_relaxed);
+                    uint64_t claimed = 0;
+                    for(size_t id = w * 64; id < min(n, w * 64 + 64); id++) {
+                        if(seen & (1ULL << (id % 64))) continue;
+                        for(int e = inOffsets[id]; e < inOffsets[id + 1]; e++) {
+                            int parent = inTargets[e];
+                            if(frontierBits[parent / 64] & (1ULL << (parent % 64))) {
+                                claimed |= 1ULL << (id % 64);
+                                next.push_back((int)id);
+                                break;
+                            }
+                        }
+                    }
+                    visited[w].store(seen | claimed, memory_order_relaxed);
+                }
+            }, 1 << 10);
+        } else {
+            parallelFor(frontier.size(), [&](size_t begin, size_t end, int worker) {
+                vector<int>& next = localNext[worker];
+                for(size_t i = begin; i < end; i++) {
+                    int current = frontier[i];
+                    for(int e = outOffsets[current]; e < outOffsets[current + 1]; e++) {
+                        int neighbour = outTargets[e];
+                        uint64_t bit = 1ULL << (neighbour % 64);
+                        if(visited[neighbour / 64].load(memory_order_relaxed) & bit) continue;
+                        if(!(visited[neighbour / 64].fetch_or(bit, memory_order_relaxed) & bit)) {
+                            next.push_back(neighbour);
+                        }
+                    }
+                }
+            }, 1 << 10);
+        }
+        
+        frontier.clear();
+        for(vector<int>& next : localNext) {
+            frontier.insert(frontier.end(), next.begin(), next.end());
+        }
+        sort(frontier.begin(), frontier.end());
+        
+        // A hop that found nothing ends the search and is not recorded
+        if(!frontier.empty()) {
+            state.reached.insert(state.reached.end(), frontier.begin(), frontier.end());
+            state.hopStarts.push_back((int)state.reached.size());
+        }
+        return true;
+    }
+    
+    /**
+     * Direction-optimizing breadth-first search from a single course, run to completion
+     * @param sourceId ID to start from (not included in the result)
+     * @param direction Whether to follow dependent or prerequisite edges
+     * @param maxHops Maximum distance to explore, negative for unlimited
+     * @param reached Output: reached IDs, sorted by hop distance then ID
+     * @param hopStarts Output: reached[hopStarts[h - 1] .. hopStarts[h]) are h hops away
+     * Time Complexity: O(V + E) work, O(D) parallel steps for a graph of depth D
+     */
+    void parallelBfs(int sourceId, TraversalDirection direction, int maxHops,
+                     vector<int>& reached, vector<int>& hopStarts) {
+        BfsState state;
+        startBfs(csrView(), sourceId, direction, maxHops, state);
+        while(expandHop(state)) {}
+        reached = move(state.reached);
+        hopStarts = move(state.hopStarts);
+    }
+    
+    /**
+     * Give levels to the courses that Kahn's algorithm left on or behind a cycle
+     *
+     * An OR-group is satisfied once its first alternative is resolved, so a course
+     * whose groups each have an alternative off the cycle can still be completed.
+     * Courses are settled in order of level from a min-heap, as in Dijkstra's
+     * algorithm: the first settled alternative of a group is then its shallowest,
+     * and a course is settled one level after the prerequisite that satisfies its
+     * last open group. Courses with a group that is never satisfied keep level 0.
+     * Topological positions are left alone, since the order must respect every edge.
+     *
+     * Time Complexity: O((V + E) log V) plus the group sizes of the unresolved courses
+     */
+    void levelBehindCycles() {
+        int n = (int)courseKeys.size();
+        vector<int> openGroups(n, 0);
+        vector<vector<char>> satisfiedGroups(n);
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pending;
+        for(int id = 0; id < n; id++) {
+            if(topologicalPosition[id] < 0) {
+                openGroups[id] = (int)prerequisiteGroupIds[id].size();
+                satisfiedGroups[id].assign(openGroups[id], 0);
+            } else {
+                pending.emplace(courseLevels[id], id);
+            }
+        }
+        
+        while(!pending.empty()) {
+            auto [level, current] = pending.top();
+            pending.pop();
+            
+            for(int dependent : dependentIds[current]) {
+                if(topologicalPosition[dependent] >= 0 || openGroups[dependent] == 0) continue;
+                
+                const vector<vector<int>>& groups = prerequisiteGroupIds[dependent];
+                for(size_t g = 0; g < groups.size(); g++) {
+                    if(satisfiedGroups[dependent][g]) continue;
+                    if(find(groups[g].begin(), groups[g].end(), current) == groups[g].end()) continue;
+                    satisfiedGroups[dependent][g] = 1;
+                    if(--openGroups[dependent] == 0) {
+                        courseLevels[dependent] = level + 1;
+                        pending.emplace(level + 1, dependent);
+                    }
+                }
+            }
+        }
+    }
+    
+public:
+    /**
+     * Add a course and its prerequisite relationships to the graph
+     *
+     * Re-adding a course replaces its previous definition. Once levels have been
+     * computed for the first time, every later definition that would create a
+     * prerequisite cycle is rejected before anything is recorded, and the
+     * topological order and levels are updated in place while the graph is
+     * acyclic. Before that (e.g. while bulk loading) courses are only recorded,
+     * and any cycle shows up later as level 0.
+     *
+     * @param course Course object containing prerequisite information
+     * @return false if the definition was rejected for creating a cycle
+     * Time Complexity: O(p) where p is number of prerequisites, plus the affected region when maintained
+     */
+    bool addCourse(const Course& course) {
+        string courseKey = toLower(course.courseNumber);
+        
+        vector<vector<string>> groups = course.prerequisiteGroups;
+        if(groups.empty()) {
+            for(const string& prereq : course.prerequisites) {
+                groups.push_back(vector<string>(1, prereq));
+            }
+        }
+        
+        if(rejectCycles) {
+            if(!levelsValid) {
+                computeLevels();
+            }
+            
+            // Courses not yet in the graph have no dependents, so only known ones can close a cycle
+            vector<int> knownPrereqs;
+            for(const vector<string>& group : groups) {
+                for(const string& alternative : group) {
+                    string prereqKey = toLower(alternative);
+                    if(prereqKey == courseKey) return false;
+                    auto known = courseIds.find(prereqKey);
+                    if(known != courseIds.end()) knownPrereqs.push_back(known->second);
+                }
+            }
+            auto existing = courseIds.find(courseKey);
+            if(existing != courseIds.end() && createsCycle(existing->second, knownPrereqs)) {
+                return false;
+            }
+        }
+        
+        int courseId = internCourse(courseKey);
+        vector<vector<int>> groupIds = internGroups(groups);
+        
+        adjacencyList[courseKey];
+        setPrerequisiteGroups(courseId, groupIds);
+        corequisiteGroupIds[courseId] = internGroups(course.corequisiteGroups);
+        return true;
+    }
+    
+    /**
+     * Remove a course definition from the graph
+     *
+     * The course loses its prerequisites. If other courses still require it, it stays
+     * behind as an undefined prerequisite, just like a prerequisite that was never
+     * defined in the file; otherwise it is dropped entirely.
+     *
+     * @param courseNumber Course to remove
+     * @return false if the course is not in the graph
+     * Time Complexity: O(p + d) plus the affected region of the level update
+     */
+    bool removeCourse(const string& courseNumber) {
+        string courseKey = toLower(courseNumber);
+        auto it = courseIds.find(courseKey);
+        if(it == courseIds.end()) {
+            return false;
+        }
+        
+        int courseId = it->second;
+        setPrerequisiteGroups(courseId, vector<vector<int>>());
+        corequisiteGroupIds[courseId].clear();
+        adjacencyList.erase(courseKey);
+        
+        if(dependentIds[courseId].empty()) {
+            // The ID stays allocated as an isolated tombstone with an empty key
+            courseIds.erase(it);
+            reverseList.erase(courseKey);
+            courseKeys[courseId].clear();
+        }
+        return true;
+    }
+    
+    /**
+     * Make a course require another course
+     *
+     * The prerequisite is added as its own group, so it is required in addition to
+     * any existing groups. Unknown prerequisites are added as undefined courses.
+     *
+     * @param courseNumber Course gaining the prerequisite
+     * @param prereqNumber Prerequisite to add
+     * @return false if the course is unknown or the edge would create a cycle
+     * Time Complexity: O(affected region log affected region)
+     */
+    bool addEdge(const string& courseNumber, const string& prereqNumber) {
+        auto it = courseIds.find(toLower(courseNumber));
+        if(it == courseIds.end()) {
+            return false;
+        }
+        int courseId = it->second;
+        if(toLower(prereqNumber) == courseKeys[courseId]) {
+            return false;
+        }
+        
+        if(!levelsValid) {
+            computeLevels();
+        }
+        int prereqId = internCourse(toLower(prereqNumber));
+        if(createsCycle(courseId, vector<int>(1, prereqId))) {
+            return false;
+        }
+        
+        vector<vector<int>> groups = prerequisiteGroupIds[courseId];
+        for(const vector<int>& group : groups) {
+            if(group.size() == 1 && group[0] == prereqId) return true;
+        }
+        groups.push_back(vector<int>(1, prereqId));
+        setPrerequisiteGroups(courseId, groups);
+        return true;
+    }
+    
+    /**
+     * Stop a course from requiring another course
+     *
+     * Removes the prerequisite from every group of the course; an OR-group keeps
+     * its other alternatives and a group left empty is dropped.
+     *
+     * @param courseNumber Course losing the prerequisite
+     * @param prereqNumber Prerequisite to remove
+     * @return false if the course did not require the prerequisite
+     * Time Complexity: O(p) plus the affected region of the level update
+     */
+    bool removeEdge(const string& courseNumber, const string& prereqNumber) {
+        auto courseIt = courseIds.find(toLower(courseNumber));
+        auto prereqIt = courseIds.find(toLower(prereqNumber));
+        if(courseIt == courseIds.end() || prereqIt == courseIds.end()) {
+            return false;
+        }
+        int courseId = courseIt->second;
+        int prereqId = prereqIt->second;
+        
+        vector<int>& prereqs = prerequisiteIds[courseId];
+        if(find(prereqs.begin(), prereqs.end(), prereqId) == prereqs.end()) {
+            return false;
+        }
+        
+        if(!levelsValid) {
+            computeLevels();
+        }
+        vector<vector<int>> groups;
+        for(vector<int> group : prerequisiteGroupIds[courseId]) {
+            group.erase(remove(group.begin(), group.end(), prereqId), group.end());
+            if(!group.empty()) groups.push_back(group);
+        }
+        setPrerequisiteGroups(courseId, groups);
+        return true;
+    }
+    
+    /**
+     * Compute the level of every course with a single longest-path sweep over the DAG
+     *
+     * Uses Kahn's algorithm to produce a topological order, assigning each course
+     * one more than the deepest of its prerequisite groups as it is dequeued (an
+     * OR-group is as deep as its shallowest alternative). A course with
+     * no prerequisites has level 1. Courses on (or behind) a prerequisite cycle never
+     * reach in-degree zero and get no topological position; levelBehindCycles then
+     * gives them a level if each of their OR-groups has an alternative off the
+     * cycle, and the rest keep level 0.
+     *
+     * Results are cached until the graph is modified.
+     * Time Complexity: O(V + E), plus levelBehindCycles when there is a cycle
+     */
+    void computeLevels() {
+        int n = (int)courseKeys.size();
+        vector<int> inDegree(n);
+        
+        topologicalOrder.clear();
+        topologicalOrder.reserve(n);
+        topologicalPosition.assign(n, -1);
+        courseLevels.assign(n, 0);
+        
+        for(int id = 0; id < n; id++) {
+            inDegree[id] = (int)prerequisiteIds[id].size();
+            if(inDegree[id] == 0) {
+                topologicalOrder.push_back(id);
+            }
+        }
+        
+        // topologicalOrder doubles as the FIFO queue for Kahn's algorithm
+        for(size_t head = 0; head < topologicalOrder.size(); head++) {
+            int current = topologicalOrder[head];
+            
+            topologicalPosition[current] = (int)head;
+            courseLevels[current] = levelFromPrerequisites(current);
+            
+            for(int dependent : dependentIds[current]) {
+                if(--inDegree[dependent] == 0) {
+                    topologicalOrder.push_back(dependent);
+                }
+            }
+        }
+        if(topologicalOrder.size() < (size_t)n) {
+            levelBehindCycles();
+        }
+        
+        levelsValid = true;
+        rejectCycles = true;
+        levelChanges.clear();
+        levelChangesComplete = false;
+    }
+    
+    /**
+     * Get the cached level of a course
+     *
+     * The level is both the earliest semester the course can be taken (counting from 1)
+     * and the minimum number of semesters needed to complete it, taking one course of
+     * each prerequisite chain per semester.
+     *
+     * @param courseNumber Course to get the level for
+     * @return Level of the course, 0 if unknown or blocked by a prerequisite cycle
+     * Time Complexity: O(1) once levels are computed
+     */
+    int getCourseLevel(const string& courseNumber) {
+        if(!levelsValid) {
+            computeLevels();
+        }
+        
+        auto it = courseIds.find(toLower(courseNumber));
+        return (it != courseIds.end()) ? courseLevels[it->second] : 0;
+    }
+    
+    /**
+     * Collect the courses whose level changed since the previous call
+     *
+     * Incremental edits record each course whose level they change. A wholesale
+     * recomputation (the first computation, or a graph with a cycle) does not, and
+     * is reported instead so the caller can refresh everything.
+     *
+     * @param changed Output: course numbers whose level changed
+     * @return false if levels were recomputed wholesale and changed is incomplete
+     */
+    bool takeLevelChanges(vector<string>& changed) {
+        if(!levelsValid) {
+            computeLevels();
+        }
+        
+        bool complete = levelChangesComplete;
+        sort(levelChanges.begin(), levelChanges.end());
+        levelChanges.erase(unique(levelChanges.begin(), levelChanges.end()), levelChanges.end());
+        for(int id : levelChanges) {
+            if(!courseKeys[id].empty()) changed.push_back(courseKeys[id]);
+        }
+        levelChanges.clear();
+        levelChangesComplete = true;
+        return complete;
+    }
+    
+    /**
+     * Get all courses in topological order (prerequisites before dependents)
+     * @return Vector of course numbers; courses on a prerequisite cycle are omitted
+     * Time Complexity: O(V) once levels are computed
+     */
+    vector<string> getTopologicalOrder() {
+        if(!levelsValid) {
+            computeLevels();
+        }
+        
+        vector<string> order;
+        order.reserve(topologicalOrder.size());
+        for(int id : topologicalOrder) {
+            if(!courseKeys[id].empty()) order.push_back(courseKeys[id]);
+        }
+        return order;
+    }
+    
+    /**
+     * Find courses that become available after completing a given course
+     *
+     * Uses Breadth-First Search (BFS) to traverse prerequisite relationships
+     *
+     * @param completedCourse Course number that has been completed
+     * @param hashTable Reference to hash table for course lookup
+     * @return Vector of course numbers that become available
+     * Time Complexity: O(V + E) where V is courses, E is prerequisite relationships
+     */
+    vector<string> findAvailableCourses(const string& completedCourse, const CourseHashTable& hashTable) {
+        vector<string> available;
+        string courseKey = toLower(completedCourse);
+        
+        if(reverseList.find(courseKey) == reverseList.end()) {
+            return available;
+        }
+        
+        queue<string> q;
+        unordered_map<string, bool> visited;
+        
+        for(const string& dependent : reverseList[courseKey]) {
+            q.push(dependent);
+        }
+        
+        while (!q.empty()) {
+            string current = q.front();
+            q.pop();
+            
+            if(visited[current]) continue;
+            visited[current] = true;
+            
+            bool allPrereqsMet = true;
+            for(const string& prereq : adjacencyList[current]) {
+                if(toLower(prereq) != courseKey) {
+                    allPrereqsMet = false;
+                    break;
+                }
+            }
+            
+            if(allPrereqsMet) {
+                available.push_back(current);
+                
+                if(reverseList.find(current) != reverseList.end()) {
+                    for(const string& next : reverseList[current]) {
+                        if(!visited[next]) {
+                            q.push(next);
+                        }
+                    }
+                }
+            }
+        }
+        
+        return available;
+    }
+    
+    /**
+     * Get prerequisites for a specific course
+     * @param courseNumber Course to get prerequisites for
+     * @return List of prerequisite course numbers
+     */
+    list<string> getPrerequisites(const string& courseNumber) {
+        string courseKey = toLower(courseNumber);
+        return adjacencyList[courseKey];
+    }
+    
+    /**
+     * Get the courses that directly require a specific course
+     * @param courseNumber Course to get dependents for
+     * @return List of dependent course keys, empty if the course is unknown
+     * Time Complexity: O(d) where d is the number of dependents
+     */
+    list<string> getDependents(const string& courseNumber) const {
+        auto it = reverseList.find(toLower(courseNumber));
+        return (it != reverseList.end()) ? it->second : list<string>();
+    }
+    
+    /**
+     * Find every course within k hops of a course
+     *
+     * General form of the dependents/ancestors queries. Dependents are courses that
+     * (transitively) require the given course; ancestors are its (transitive)
+     * prerequisites.
+     *
+     * @param courseNumber Course to start from
+     * @param direction Whether to walk towards dependents or prerequisites
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Pairs of (course number, hop distance), nearest first; empty if the course is unknown
+     * Time Complexity: O(V + E) worst case, split across hardware threads
+     */
+    vector<pair<string, int>> findWithinHops(const string& courseNumber, TraversalDirection direction, int maxHops = -1) {
+        HopSearch search = startHopSearch(courseNumber, direction, maxHops);
+        while(search.step()) {}
+        return search.results();
+    }
+    
+    /**
+     * A findWithinHops search advanced one hop at a time, so its caller can pause between hops
+     *
+     * The graph must not change while a search is in progress.
+     */
+    class HopSearch {
+    private:
+        friend class PrerequisiteGraph;
+        const PrerequisiteGraph* graph = nullptr; // Graph whose course numbers results() reports, if any
+        bool started = false; // Whether the start course was found
+        BfsState state; // Progress so far
+        
+    public:
+        /**
+         * Expand the next hop
+         * @return false once the search is finished
+         */
+        bool step() {
+            return started && expandHop(state);
+        }
+        
+        /**
+         * Get the number of courses reached by the last hop
+         */
+        size_t frontierSize() const {
+            return state.frontier.size();
+        }
+        
+        /**
+         * Get the courses reached so far
+         * @return Pairs of (course number, hop distance), nearest first
+         */
+        vector<pair<string, int>> results() const {
+            vector<pair<string, int>> result;
+            if(!graph) return result;
+            
+            result.reserve(state.reached.size());
+            for(const pair<int, int>& reached : resultIds()) {
+                result.emplace_back(graph->courseKeys[reached.first], reached.second);
+            }
+            return result;
+        }
+        
+        /**
+         * Get the courses reached so far by ID
+         * @return Pairs of (course ID, hop distance), nearest first
+         */
+        vector<pair<int, int>> resultIds() const {
+            vector<pair<int, int>> result;
+            result.reserve(state.reached.size());
+            for(size_t hop = 1; hop < state.hopStarts.size(); hop++) {
+                for(int i = state.hopStarts[hop - 1]; i < state.hopStarts[hop]; i++) {
+                    result.emplace_back(state.reached[i], (int)hop);
+                }
+            }
+            return result;
+        }
+    };
+    
+    /**
+     * Start a k-hop search that the caller advances with HopSearch::step
+     * @param courseNumber Course to start from
+     * @param direction Whether to walk towards dependents or prerequisites
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Search positioned before its first hop; it finds nothing if the course is unknown
+     */
+    HopSearch startHopSearch(const string& courseNumber, TraversalDirection direction, int maxHops = -1) {
+        auto it = courseIds.find(toLower(courseNumber));
+        if(it == courseIds.end()) {
+            return HopSearch();
+        }
+        HopSearch search = startHopSearch(csrView(), it->second, direction, maxHops);
+        search.graph = this;
+        return search;
+    }
+    
+    /**
+     * Start a k-hop search over CSR arrays that need not belong to a graph
+     * @param edges Graph to search; its arrays must outlive the search
+     * @param sourceId ID to start from
+     * @param direction Whether to walk towards dependents or prerequisites
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Search positioned before its first hop; only resultIds() reports what it reaches
+     */
+    static HopSearch startHopSearch(const CsrGraphView& edges, int sourceId, TraversalDirection direction, int maxHops = -1) {
+        HopSearch search;
+        search.started = true;
+        startBfs(edges, sourceId, direction, maxHops, search.state);
+        return search;
+    }
+    
+    /**
+     * Count the courses within k hops of a course without materializing their names
+     * @param courseNumber Course to start from
+     * @param direction Whether to walk towards dependents or prerequisites
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Number of courses reached, 0 if the course is unknown
+     * Time Complexity: O(V + E) worst case, split across hardware threads
+     */
+    size_t countWithinHops(const string& courseNumber, TraversalDirection direction, int maxHops = -1) {
+        auto it = courseIds.find(toLower(courseNumber));
+        if(it == courseIds.end()) {
+            return 0;
+        }
+        
+        vector<int> reached, hopStarts;
+        parallelBfs(it->second, direction, maxHops, reached, hopStarts);
+        return reached.size();
+    }
+    
+    /**
+     * Find courses that require a course, directly or transitively, within k hops
+     * @param courseNumber Course to start from
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Pairs of (course number, hop distance), nearest first
+     */
+    vector<pair<string, int>> findDependents(const string& courseNumber, int maxHops = -1) {
+        return findWithinHops(courseNumber, TraversalDirection::Dependents, maxHops);
+    }
+    
+    /**
+     * Find prerequisites of a course, directly or transitively, within k hops
+     * @param courseNumber Course to start from
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Pairs of (course number, hop distance), nearest first
+     */
+    vector<pair<string, int>> findAncestors(const string& courseNumber, int maxHops = -1) {
+        return findWithinHops(courseNumber, TraversalDirection::Ancestors, maxHops);
+    }
+    
+    /**
+     * Find every course blocked if a course is cancelled
+     *
+     * Walks reverseList (via its CSR copy) to collect all transitive dependents.
+     * Like getDescendantCount, courses on or behind a prerequisite cycle are left
+     * out, so blockedCount always equals the descendant count.
+     *
+     * @param courseNumber Course being cancelled
+     * @return Report listing the blocked courses and their count
+     * Time Complexity: O(V + E) worst case
+     */
+    ImpactReport analyzeImpact(const string& courseNumber) {
+        ImpactReport report;
+        report.courseNumber = courseNumber;
+        if(!levelsValid) {
+            computeLevels();
+        }
+        
+        HopSearch search = startHopSearch(courseNumber, TraversalDirection::Dependents);
+        while(search.step()) {}
+        for(const pair<int, int>& dependent : search.resultIds()) {
+            if(topologicalPosition[dependent.first] < 0) continue;
+            report.blockedCourses.push_back(courseKeys[dependent.first]);
+        }
+        report.blockedCount = report.blockedCourses.size();
+        return report;
+    }
+    
+    /**
+     * Count the transitive dependents of every course in one pass
+     *
+     * Walks the topological order backwards, so every dependent's descendant set is
+     * complete before its prerequisites OR it in. Descendant sets are bitsets over
+     * course IDs; to bound memory the ID space is split into column blocks that fit
+     * in the given budget, and blocks are processed independently across workers.
+     * Courses on a prerequisite cycle, or depending on one, have no place in the
+     * topological order, so they neither get a count nor add to anyone else's.
+     *
+     * @param memoryBudgetBytes Upper bound on bitset memory across all workers
+     * Time Complexity: O((V + E) * V / 64)
+     * Space Complexity: O(memoryBudgetBytes)
+     */
+    void computeDescendantCounts(size_t memoryBudgetBytes = 256u << 20) {
+        if(!levelsValid) {
+            computeLevels();
+        }
+        
+        size_t n = courseKeys.size();
+        descendantCounts.assign(n, 0);
+        if(n == 0) {
+            descendantCountsValid = true;
+            return;
+        }
+        
+        size_t totalWords = (n + 63) / 64;
+        size_t workers = workerCount();
+        size_t blockWords = max<size_t>(1, memoryBudgetBytes / workers / (n * sizeof(uint64_t)));
+        blockWords = min(blockWords, totalWords);
+        size_t blocks = (totalWords + blockWords - 1) / blockWords;
+        
+        vector<vector<int>> localCounts(workers);
+        parallelFor(blocks, [&](size_t begin, size_t end, int worker) {
+            vector<int>& counts = localCounts[worker];
+            counts.assign(n, 0);
+            vector<uint64_t> rows(n * blockWords);
+            
+            for(size_t block = begin; block < end; block++) {
+                size_t firstWord = block * blockWords;
+                size_t width = min(blockWords, totalWords - firstWord);
+                size_t firstId = firstWord * 64;
+                size_t lastId = min(n, (firstWord + width) * 64);
+                fill(rows.begin(), rows.end(), 0);
+                
+                for(auto it = topologicalOrder.rbegin(); it != topologicalOrder.rend(); ++it) {
+                    int current = *it;
+                    uint64_t* row = &rows[(size_t)current * blockWords];
+                    
+                    for(int dependent : dependentIds[current]) {
+                        if(topologicalPosition[dependent] < 0) continue;
+                        const uint64_t* dependentRow = &rows[(size_t)dependent * blockWords];
+                        for(size_t w = 0; w < width; w++) {
+                            row[w] |= dependentRow[w];
+                        }
+                        if((size_t)dependent >= firstId && (size_t)dependent < lastId) {
+                            size_t offset = dependent - firstId;
+                            row[offset / 64] |= 1ULL << (offset % 64);
+                        }
+                    }
+                    
+                    int count = 0;
+                    for(size_t w = 0; w < width; w++) {
+                        count += __builtin_popcountll(row[w]);
+                    }
+                    counts[current] += count;
+                }
+            }
+        }, 2);
+        
+        for(const vector<int>& counts : localCounts) {
+            for(size_t id = 0; id < counts.size(); id++) {
+                descendantCounts[id] += counts[id];
+            }
+        }
+        descendantCountsValid = true;
+    }
+    
+    /**
+     * Get the number of courses blocked if a course is cancelled
+     * @param courseNumber Course to look up
+     * @return Number of transitive dependents, 0 if the course is unknown
+     * Time Complexity: O(1) once counts are computed
+     */
+    int getDescendantCount(const string& courseNumber) {
+        if(!descendantCountsValid) {
+            computeDescendantCounts();
+        }
+        
+        auto it = courseIds.find(toLower(courseNumber));
+        return (it != courseIds.end()) ? descendantCounts[it->second] : 0;
+    }
+    
+    /**
+     * Rank courses by how many other courses they transitively block
+     * @param limit Maximum number of courses to return, 0 for all
+     * @return Pairs of (course number, descendant count), most critical first, ties by course number
+     * Time Complexity: O(V log V) once counts are computed
+     */
+    vector<pair<string, int>> rankByCriticality(size_t limit = 0) {
+        if(!descendantCountsValid) {
+            computeDescendantCounts();
+        }
+        
+        vector<int> ids;
+        for(size_t id = 0; id < courseKeys.size(); id++) {
+            if(!courseKeys[id].empty()) ids.push_back((int)id);
+        }
+        
+        size_t count = (limit == 0) ? ids.size() : min(limit, ids.size());
+        partial_sort(ids.begin(), ids.begin() + count, ids.end(), [this](int a, int b) {
+            if(descendantCounts[a] != descendantCounts[b]) return descendantCounts[a] > descendantCounts[b];
+            return courseKeys[a] < courseKeys[b];
+        });
+        
+        vector<pair<string, int>> ranking;
+        ranking.reserve(count);
+        for(size_t i = 0; i < count; i++) {
+            ranking.emplace_back(courseKeys[ids[i]], descendantCounts[ids[i]]);
+        }
+        return ranking;
+    }
+    
+    /**
+     * Relabel course IDs so courses that are traversed together are stored together
+     *
+     * Every per-course array is permuted to the new IDs, so CSR neighbour lists,
+     * bitmaps and cached levels of related courses share cache lines. Removed
+     * courses are moved to the end. Bitsets built before reordering are invalidated.
+     *
+     * @param strategy Relabeling strategy to use
+     * Time Complexity: O(V log V + E log E)
+     */
+    void reorderCourseIds(ReorderStrategy strategy) {
+        if(!levelsValid) {
+            computeLevels();
+        }
+        
+        size_t n = courseKeys.size();
+        vector<int> order; // New ID -> old ID
+        order.reserve(n);
+        
+        if(strategy == ReorderStrategy::DepartmentLevel) {
+            vector<string> departments(n);
+            for(size_t id = 0; id < n; id++) {
+                if(courseKeys[id].empty()) continue;
+                order.push_back((int)id);
+                size_t digits = courseKeys[id].find_first_of("0123456789");
+                departments[id] = courseKeys[id].substr(0, digits);
+            }
+            sort(order.begin(), order.end(), [&](int a, int b) {
+                if(departments[a] != departments[b]) return departments[a] < departments[b];
+                if(courseLevels[a] != courseLevels[b]) return courseLevels[a] < courseLevels[b];
+                return courseKeys[a] < courseKeys[b];
+            });
+        } else {
+            // Cuthill-McKee over the undirected graph, one component at a time
+            auto degree = [this](int id) { return prerequisiteIds[id].size() + dependentIds[id].size(); };
+            vector<int> byDegree;
+            for(size_t id = 0; id < n; id++) {
+                if(!courseKeys[id].empty()) byDegree.push_back((int)id);
+            }
+            stable_sort(byDegree.begin(), byDegree.end(), [&](int a, int b) { return degree(a) < degree(b); });
+            
+            vector<char> placed(n, 0);
+            vector<int> neighbours;
+            for(int root : byDegree) {
+                if(placed[root]) continue;
+                placed[root] = 1;
+                order.push_back(root);
+                
+                for(size_t head = order.size() - 1; head < order.size(); head++) {
+                    int current = order[head];
+                    
+                    neighbours.clear();
+                    for(int id : prerequisiteIds[current]) if(!placed[id]) { placed[id] = 1; neighbours.push_back(id); }
+                    for(int id : dependentIds[current]) if(!placed[id]) { placed[id] = 1; neighbours.push_back(id); }
+                    stable_sort(neighbours.begin(), neighbours.end(), [&](int a, int b) { return degree(a) < degree(b); });
+                    
+                    order.insert(order.end(), neighbours.begin(), neighbours.end());
+                }
+            }
+            reverse(order.begin(), order.end());
+        }
+        
+        for(size_t id = 0; id < n; id++) {
+            if(courseKeys[id].empty()) order.push_back((int)id);
+        }
+        
+        vector<int> newId(n);
+        for(size_t i = 0; i < n; i++) {
+            newId[order[i]] = (int)i;
+        }
+        
+        auto relabelList = [&](vector<int>& ids) {
+            for(int& id : ids) id = newId[id];
+        };
+        auto relabelGroups = [&](vector<vector<int>>& groups) {
+            for(vector<int>& group : groups) relabelList(group);
+        };
+        
+        vector<string> keys(n);
+        vector<vector<int>> prereqs(n), dependents(n);
+        vector<vector<vector<int>>> prereqGroups(n), coreqGroups(n);
+        vector<int> levels(n);
+        for(size_t i = 0; i < n; i++) {
+            int old = order[i];
+            keys[i] = move(courseKeys[old]);
+            prereqs[i] = move(prerequisiteIds[old]);
+            dependents[i] = move(dependentIds[old]);
+            prereqGroups[i] = move(prerequisiteGroupIds[old]);
+            coreqGroups[i] = move(corequisiteGroupIds[old]);
+            levels[i] = courseLevels[old];
+            
+            relabelList(prereqs[i]);
+            relabelList(dependents[i]);
+            relabelGroups(prereqGroups[i]);
+            relabelGroups(coreqGroups[i]);
+            if(!keys[i].empty()) courseIds[keys[i]] = (int)i;
+        }
+        courseKeys = move(keys);
+        prerequisiteIds = move(prereqs);
+        dependentIds = move(dependents);
+        prerequisiteGroupIds = move(prereqGroups);
+        corequisiteGroupIds = move(coreqGroups);
+        courseLevels = move(levels);
+        
+        relabelList(topologicalOrder);
+        topologicalPosition.assign(n, -1);
+        for(size_t position = 0; position < topologicalOrder.size(); position++) {
+            topologicalPosition[topologicalOrder[position]] = (int)position;
+        }
+        if(topologicalOrder.size() < n) {
+            // Courses on a cycle have no position; recompute rather than track them
+            levelsValid = false;
+        }
+        
+        csrValid = false;
+        descendantCountsValid = false;
+        requirementsValid = false;
+    }
+    
+    /**
+     * Compute which courses every student in a cohort may take next
+     *
+     * Transcripts are first transposed into one bitset over students per course,
+     * so each prerequisite test handles 64 students per word operation: a course's
+     * row is the AND over its groups of the OR over each group's alternatives,
+     * minus the students who already completed it. The word loops are plain
+     * bitwise operations the compiler vectorizes, and courses are split across
+     * worker threads. With no enrolled courses to go by, co-requisite groups must
+     * already be completed, as in isEligible and findEligibleCourses.
+     *
+     * @param transcripts Completed courses of each student, built with makeCourseSet
+     * @return Matrix of eligible (student, course ID) pairs
+     * Time Complexity: O(total completions + (V + E) * students / 64)
+     */
+    EligibilityMatrix computeEligibilityMatrix(const vector<CourseBitset>& transcripts) {
+        size_t n = courseKeys.size();
+        size_t students = transcripts.size();
+        EligibilityMatrix completed(n, students);
+        EligibilityMatrix eligible(n, students);
+        size_t words = completed.wordsPerRow();
+        
+        // Transpose: workers own disjoint 64-student words, so they never write the same word
+        parallelFor(words, [&](size_t begin, size_t end, int) {
+            for(size_t student = begin * 64; student < min(students, end * 64); student++) {
+                const CourseBitset& transcript = transcripts[student];
+                const uint64_t* courseWords = transcript.data();
+                for(size_t cw = 0; cw < transcript.wordCount(); cw++) {
+                    for(uint64_t remaining = courseWords[cw]; remaining; remaining &= remaining - 1) {
+                        size_t courseId = cw * 64 + __builtin_ctzll(remaining);
+                        if(courseId >= n) break;
+                        completed.row((int)courseId)[student / 64] |= 1ULL << (student % 64);
+                    }
+                }
+            }
+        }, 64);
+        
+        parallelFor(n, [&](size_t begin, size_t end, int) {
+            vector<uint64_t> groupBits(words);
+            for(size_t courseId = begin; courseId < end; courseId++) {
+                if(courseKeys[courseId].empty()) continue;
+                
+                uint64_t* result = eligible.row((int)courseId);
+                const uint64_t* done = completed.row((int)courseId);
+                for(size_t w = 0; w < words; w++) {
+                    result[w] = ~done[w];
+                }
+                
+                for(const auto* groups : {&prerequisiteGroupIds[courseId], &corequisiteGroupIds[courseId]}) {
+                    for(const vector<int>& group : *groups) {
+                        const uint64_t* first = completed.row(group[0]);
+                        if(group.size() == 1) {
+                            for(size_t w = 0; w < words; w++) result[w] &= first[w];
+                            continue;
+                        }
+                        
+                        copy(first, first + words, groupBits.begin());
+                        for(size_t a = 1; a < group.size(); a++) {
+                            const uint64_t* alternative = completed.row(group[a]);
+                            for(size_t w = 0; w < words; w++) groupBits[w] |= alternative[w];
+                        }
+                        for(size_t w = 0; w < words; w++) result[w] &= groupBits[w];
+                    }
+                }
+                
+                if(students % 64 != 0 && words > 0) {
+                    result[words - 1] &= (1ULL << (students % 64)) - 1;
+                }
+            }
+        }, 64);
+        
+        return eligible;
+    }
+    
+    /**
+     * Run a compiled requirement program against a transcript
+     * @param first First instruction of the program
+     * @param last One past the last instruction
+     * @param completed Courses already completed
+     * @param enrolled Courses being taken this semester (co-requisites only), may be null
+     * @return true if every requirement group is satisfied
+     * Time Complexity: O(instructions), typically a handful of word tests
+     */
+    static bool evaluateProgram(const RequirementOp* first, const RequirementOp* last,
+                                const CourseBitset& completed, const CourseBitset* enrolled) {
+        const uint64_t* done = completed.data();
+        size_t doneWords = completed.wordCount();
+        bool groupSatisfied = false;
+        
+        for(const RequirementOp* op = first; op != last; op++) {
+            uint64_t have = (op->word < doneWords) ? done[op->word] : 0;
+            if((op->flags & RequirementOp::COREQUISITE) && enrolled && op->word < enrolled->wordCount()) {
+                have |= enrolled->data()[op->word];
+            }
+            
+            if(!(op->flags & RequirementOp::ANY)) {
+                if((have & op->mask) != op->mask) return false;
+            } else {
+                groupSatisfied |= (have & op->mask) != 0;
+                if(op->flags & RequirementOp::END_GROUP) {
+                    if(!groupSatisfied) return false;
+                    groupSatisfied = false;
+                }
+            }
+        }
+        return true;
+    }
+    
+    /**
+     * Get the integer ID of a course
+     * @param courseNumber Course to look up
+     * @return Course ID, or -1 if the course is unknown
+     */
+    int getCourseId(const string& courseNumber) const {
+        auto it = courseIds.find(toLower(courseNumber));
+        return (it != courseIds.end()) ? it->second : -1;
+    }
+    
+    /**
+     * Get the course number stored for an integer ID
+     * @param id Course ID
+     * @return Lowercase course number, empty if the course was removed
+     */
+    const string& getCourseKey(int id) const {
+        return courseKeys[id];
+    }
+    
+    /**
+     * Get the number of course IDs in use, including removed courses
+     * @return Course ID count
+     */
+    size_t courseCount() const {
+        return courseKeys.size();
+    }
+    
+    /**
+     * Get the compiled requirement programs of every course, compiling them if needed
+     * @return View valid until the graph next changes
+     */
+    RequirementProgramView requirementPrograms() {
+        if(!requirementsValid) {
+            compileRequirements();
+        }
+        return {requirementOps.data(), requirementOffsets.data(), courseKeys.size()};
+    }
+    
+    /**
+     * Build a bitset over this graph's course IDs from a list of course numbers
+     * @param courseNumbers Courses to include; unknown course numbers are ignored
+     * @return Bitset for use with isEligible and findEligibleCourses
+     */
+    CourseBitset makeCourseSet(const vector<string>& courseNumbers) const {
+        CourseBitset set(courseKeys.size());
+        for(const string& courseNumber : courseNumbers) {
+            auto it = courseIds.find(toLower(courseNumber));
+            if(it != courseIds.end()) {
+                set.set(it->second);
+            }
+        }
+        return set;
+    }
+    
+    /**
+     * Check if a student may take a course
+     * @param courseNumber Course to check
+     * @param completed Courses the student has completed
+     * @param enrolled Courses the student is taking this semester, may be null
+     * @return true if all prerequisite and co-requisite groups are satisfied
+     * Time Complexity: O(1) per instruction of the compiled program
+     */
+    bool isEligible(const string& courseNumber, const CourseBitset& completed, const CourseBitset* enrolled = nullptr) {
+        if(!requirementsValid) {
+            compileRequirements();
+        }
+        
+        auto it = courseIds.find(toLower(courseNumber));
+        return it != courseIds.end() && evaluateRequirements(it->second, completed, enrolled);
+    }
+    
+    /**
+     * Find every course a student may take that they have not completed
+     *
+     * A range of IDs can be checked at a time, so a long scan can be split up;
+     * courseCount() bounds the IDs.
+     *
+     * @param completed Courses the student has completed
+     * @param enrolled Courses the student is taking this semester, may be null
+     * @param firstId First course ID to check
+     * @param lastId One past the last course ID to check
+     * @return Course numbers whose requirements are satisfied, in ID order
+     * Time Complexity: O(total program size)
+     */
+    vector<string> findEligibleCourses(const CourseBitset& completed, const CourseBitset* enrolled = nullptr,
+                                       size_t firstId = 0, size_t lastId = SIZE_MAX) {
+        if(!requirementsValid) {
+            compileRequirements();
+        }
+        
+        vector<string> eligible;
+        for(size_t id = firstId; id < min(lastId, courseKeys.size()); id++) {
+            if(courseKeys[id].empty()) continue;
+            if(!completed.test((int)id) && evaluateRequirements((int)id, completed, enrolled)) {
+                eligible.push_back(courseKeys[id]);
+            }
+        }
+        return eligible;
+    }
+};
+
+
+/**
+ * Work-Stealing Thread Pool
+ *
+ * Each worker owns a deque of tasks: it pushes and pops its own tasks at the back
+ * (newest first, for cache reuse in fork-join recursion) and steals from the front
+ * of other workers' deques (oldest, and so largest, first) when it runs dry.
+ * Threads waiting on a TaskGroup help by running queued tasks, so forked work
+ * never deadlocks and the waiting thread counts as one more worker.
+ */
+class WorkStealingPool {
+private:
+    struct WorkerQueue {
+        mutex lock; // Guards tasks
+        deque<function<void()>> tasks; // Owner uses the back, thieves the front
+    };
+    
+    vector<unique_ptr<WorkerQueue>> queues; // One per worker, plus one for outside threads
+    vector<thread> threads; // Worker threads
+    atomic<bool> stopping{false}; // Set when the pool is shutting down
+    atomic<size_t> queuedTasks{0}; // Tasks waiting in any queue
+    mutex sleepLock; // Guards sleeping on wake
+    condition_variable wake; // Signalled when tasks are queued or the pool stops
+    
+    static thread_local WorkStealingPool* currentPool; // Pool the calling thread works for, if any
+    static thread_local size_t currentQueue; // Queue owned by the calling worker
+    
+    /**
+     * Take a task, preferring the given queue's newest task, else stealing the oldest from another
+     * @param home Queue to try first
+     * @param task Output: the task taken
+     * @return true if a task was taken
+     */
+    bool takeTask(size_t home, function<void()>& task) {
+        for(size_t k = 0; k < queues.size(); k++) {
+            WorkerQueue& queue = *queues[(home + k) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if(queue.tasks.empty()) continue;
+            
+            if(k == 0) {
+                task = move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            queuedTasks--;
+            return true;
+        }
+        return false;
+    }
+    
+    /**
+     * Worker thread body: run tasks until the pool stops
+     * @param index Queue owned by this worker
+     */
+    void workerLoop(size_t index) {
+        currentPool = this;
+        currentQueue = index;
+        
+        function<void()> task;
+        while(!stopping) {
+            if(takeTask(index, task)) {
+                task();
+                continue;
+            }
+            unique_lock<mutex> guard(sleepLock);
+            wake.wait_for(guard, chrono::milliseconds(1), [this]() { return stopping || queuedTasks > 0; });
+        }
+    }
+    
+public:
+    /**
+     * Start a pool
+     * @param threadCount Number of worker threads (threads waiting on a TaskGroup help as well)
+     */
+    explicit WorkStealingPool(unsigned threadCount) {
+        for(unsigned i = 0; i <= threadCount; i++) {
+            queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+        }
+        for(unsigned i = 0; i < threadCount; i++) {
+            threads.emplace_back(&WorkStealingPool::workerLoop, this, (size_t)i);
+        }
+    }
+    
+    /**
+     * Stop the pool once the workers finish their current tasks
+     */
+    ~WorkStealingPool() {
+        stopping = true;
+        wake.notify_all();
+        for(thread& t : threads) {
+            t.join();
+        }
+    }
+    
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    
+    /**
+     * Queue a task on the calling worker's own deque, or the shared outside queue
+     * @param task Task to run
+     */
+    void submit(function<void()> task) {
+        size_t index = (currentPool == this) ? currentQueue : threads.size();
+        {
+            lock_guard<mutex> guard(queues[index]->lock);
+            queues[index]->tasks.push_back(move(task));
+        }
+        queuedTasks++;
+        wake.notify_one();
+    }
+    
+    /**
+     * Run one queued task on the calling thread, if any is available
+     * @return true if a task was run
+     */
+    bool runPendingTask() {
+        function<void()> task;
+        size_t home = (currentPool == this) ? currentQueue : threads.size();
+        if(!takeTask(home, task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+};
+
+thread_local WorkStealingPool* WorkStealingPool::currentPool = nullptr;
+thread_local size_t WorkStealingPool::currentQueue = 0;
+
+
+/**
+ * Task Group
+ *
+ * Fork-join scope over a WorkStealingPool: run() forks tasks and wait() joins
+ * them, running queued tasks on the waiting thread in the meantime.
+ */
+class TaskGroup {
+private:
+    WorkStealingPool& pool; // Pool tasks are forked on
+    atomic<size_t> pending{0}; // Forked tasks not yet finished
+    
+public:
+    /**
+     * Create an empty group
+     * @param taskPool Pool to fork tasks on
+     */
+    explicit TaskGroup(WorkStealingPool& taskPool) : pool(taskPool) {}
+    
+    /**
+     * Wait for any tasks still running before the group goes out of scope
+     */
+    ~TaskGroup() {
+        wait();
+    }
+    
+    /**
+     * Fork a task
+     * @param task Task to run on the pool
+     */
+    void run(function<void()> task) {
+        pending++;
+        pool.submit([this, task]() {
+            task();
+            pending--;
+        });
+    }
+    
+    /**
+     * Join all forked tasks, helping with queued work while waiting
+     */
+    void wait() {
+        while(pending > 0) {
+            if(!pool.runPendingTask()) {
+                this_thread::yield();
+            }
+        }
+    }
+};
+
+
+/**
+ * Coroutine Frame Cache
+ *
+ * Keeps freed coroutine frames on a per-thread free list by size class, since
+ * every query allocates at least one frame and query frames are too large for
+ * malloc's fast path. A frame freed on another thread than it was allocated on
+ * joins that thread's list. Frames over MAX_SIZE go straight to the heap.
+ */
+class FrameCache {
+private:
+    static const size_t GRANULE = 256; // Size class width in bytes
+    static const size_t MAX_SIZE = 8192; // Largest frame cached
+    static const size_t MAX_FREE = 64; // Frames kept per size class
+    
+    struct FreeFrame {
+        FreeFrame* next;
+    };
+    
+    FreeFrame* free[MAX_SIZE / GRANULE] = {}; // Free list heads, by size class
+    size_t freeCount[MAX_SIZE / GRANULE] = {}; // Free list lengths
+    
+    FrameCache() = default;
+    
+    ~FrameCache() {
+        for (size_t sizeClass = 0; sizeClass < MAX_SIZE / GRANULE; sizeClass++) {
+            while (free[sizeClass]) {
+                FreeFrame* frame = free[sizeClass];
+                free[sizeClass] = frame->next;
+                ::operator delete(frame);
+            }
+        }
+    }
+    
+    static FrameCache& local() {
+        thread_local FrameCache cache;
+        return cache;
+    }
+    
+public:
+    static void* allocate(size_t size) {
+        if (size > MAX_SIZE) return ::operator new(size);
+        FrameCache& cache = local();
+        size_t sizeClass = (size - 1) / GRANULE;
+        if (FreeFrame* frame = cache.free[sizeClass]) {
+            cache.free[sizeClass] = frame->next;
+            cache.freeCount[sizeClass]--;
+            return frame;
+        }
+        return ::operator new((sizeClass + 1) * GRANULE);
+    }
+    
+    static void release(void* memory, size_t size) {
+        FrameCache& cache = local();
+        size_t sizeClass = (size - 1) / GRANULE;
+        if (size > MAX_SIZE || cache.freeCount[sizeClass] >= MAX_FREE) {
+            ::operator delete(memory);
+            return;
+        }
+        FreeFrame* frame = static_cast<FreeFrame*>(memory);
+        frame->next = cache.free[sizeClass];
+        cache.free[sizeClass] = frame;
+        cache.freeCount[sizeClass]++;
+    }
+};
+
+
+/**
+ * Detached Coroutine
+ *
+ * Return type for fire-and-forget coroutines: it starts running immediately and
+ * frees itself when it finishes. Nothing can wait for it, so it must not throw.
+ */
+struct DetachedCoroutine {
+    struct promise_type {
+        static void* operator new(size_t size) { return FrameCache::allocate(size); }
+        static void operator delete(void* frame, size_t size) { FrameCache::release(frame, size); }
+        
+        DetachedCoroutine get_return_object() noexcept { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { terminate(); }
+    };
+};
+
+
+template <typename T = void>
+class Task;
+
+
+/**
+ * State shared by every Task promise: the awaiting coroutine and any exception
+ */
+struct TaskPromiseBase {
+    coroutine_handle<> continuation; // Coroutine awaiting the task, resumed when it finishes
+    exception_ptr error; // Exception escaping the task, rethrown to its awaiter
+    
+    /**
+     * Resume the awaiting coroutine directly when the task finishes, so long chains
+     * of awaited tasks do not grow the stack
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        
+        template <typename Promise>
+        coroutine_handle<> await_suspend(coroutine_handle<Promise> finished) noexcept {
+            coroutine_handle<> next = finished.promise().continuation;
+            return next ? next : noop_coroutine();
+        }
+        
+        void await_resume() const noexcept {}
+    };
+    
+    static void* operator new(size_t size) { return FrameCache::allocate(size); }
+    static void operator delete(void* frame, size_t size) { FrameCache::release(frame, size); }
+    
+    suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = current_exception(); }
+};
+
+/**
+ * Promise of a Task returning a value
+ */
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    optional<T> value; // Result, once the task has returned
+    
+    Task<T> get_return_object() noexcept;
+    
+    template <typename U>
+    void return_value(U&& result) {
+        value.emplace(forward<U>(result));
+    }
+    
+    T take() {
+        if (error) rethrow_exception(error);
+        return move(*value);
+    }
+};
+
+/**
+ * Promise of a Task returning nothing
+ */
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+    
+    void take() {
+        if (error) rethrow_exception(error);
+    }
+};
+
+
+/**
+ * Coroutine Task
+ *
+ * A lazily started coroutine producing a T. The task runs when it is awaited and
+ * resumes its awaiter when it finishes, on whichever thread it finished on, so a
+ * chain of awaited tasks suspends and resumes as one unit. Exceptions propagate to
+ * the awaiter. Start a top-level task with CoroutineScheduler::spawn or syncWait.
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    
+private:
+    coroutine_handle<promise_type> handle; // Owned coroutine, null once moved from
+    
+public:
+    explicit Task(coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+    
+    Task(Task&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+    
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    
+    /**
+     * Awaiting a task starts it and returns its result
+     */
+    bool await_ready() const noexcept {
+        return handle.done();
+    }
+    
+    coroutine_handle<> await_suspend(coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    
+    T await_resume() {
+        return handle.promise().take();
+    }
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+
+/**
+ * Run a task to completion, blocking the calling thread while it is suspended
+ * @param task Task to run
+ * @return The task's result
+ */
+template <typename T>
+T syncWait(Task<T> task)
+{
+    mutex lock;
+    condition_variable finished;
+    bool done = false;
+    exception_ptr error;
+    optional<conditional_t<is_void_v<T>, bool, T>> result;
+    
+    auto signal = [&]() -> DetachedCoroutine {
+        try {
+            if constexpr (is_void_v<T>) {
+                co_await move(task);
+            } else {
+                result.emplace(co_await move(task));
+            }
+        } catch (...) {
+            error = current_exception();
+        }
+        lock_guard<mutex> guard(lock);
+        done = true;
+        finished.notify_one();
+    };
+    signal();
+    
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [&]() { return done; });
+    if (error) rethrow_exception(error);
+    if constexpr (is_void_v<T>) {
+        return;
+    } else {
+        return move(*result);
+    }
+}
+
+
+/**
+ * Coroutine Scheduler
+ *
+ * Runs coroutines on a fixed pool of threads. A coroutine moves onto the pool by
+ * awaiting schedule(), and a long-running one awaits yield() at safe points so
+ * queued work gets a turn. New and yielded coroutines wait in separate FIFO
+ * lanes: workers take new work first, so a quick lookup that arrives behind a
+ * slow plan waits for one slice of it rather than all of it, and every
+ * FAIR_SHARE-th pick takes yielded work so slow queries still progress under
+ * constant load.
+ */
+class CoroutineScheduler {
+private:
+    static const int FAIR_SHARE = 32;
+    
+    mutex lock; // Guards the lanes and stopping
+    condition_variable wake; // Signalled when a coroutine is queued or the scheduler stops
+    deque<coroutine_handle<>> fresh; // Coroutines that have just arrived
+    deque<coroutine_handle<>> yielded; // Coroutines that paused to let others run
+    atomic<size_t> queued{0}; // Coroutines waiting in either lane
+    bool stopping = false; // Set when the scheduler is shutting down
+    vector<thread> threads; // Worker threads
+    
+    void enqueue(coroutine_handle<> coroutine, bool paused) {
+        {
+            lock_guard<mutex> guard(lock);
+            (paused ? yielded : fresh).push_back(coroutine);
+            queued++;
+        }
+        wake.notify_one();
+    }
+    
+    /**
+     * Worker thread body: resume queued coroutines until stopped with both lanes empty
+     */
+    void workerLoop() {
+        int freshStreak = 0;
+        while (true) {
+            coroutine_handle<> next;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [this]() { return stopping || !fresh.empty() || !yielded.empty(); });
+                if (fresh.empty() && yielded.empty()) return;
+                
+                bool takeYielded = !yielded.empty() && (fresh.empty() || freshStreak >= FAIR_SHARE);
+                deque<coroutine_handle<>>& lane = takeYielded ? yielded : fresh;
+                next = lane.front();
+                lane.pop_front();
+                queued--;
+                freshStreak = takeYielded ? 0 : freshStreak + 1;
+            }
+            next.resume();
+        }
+    }
+    
+    static DetachedCoroutine runDetached(CoroutineScheduler& scheduler, Task<void> task) {
+        co_await scheduler.schedule();
+        co_await task;
+    }
+    
+public:
+    /**
+     * Awaitable that resumes the awaiting coroutine on a worker thread
+     */
+    struct ScheduleAwaiter {
+        CoroutineScheduler& scheduler;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(coroutine_handle<> coroutine) { scheduler.enqueue(coroutine, false); }
+        void await_resume() const noexcept {}
+    };
+    
+    /**
+     * Awaitable that requeues the awaiting coroutine behind waiting work; it does
+     * not suspend when nothing is waiting, or when it has no scheduler
+     */
+    struct YieldAwaiter {
+        CoroutineScheduler* scheduler;
+        bool await_ready() const noexcept { return !scheduler || scheduler->queued.load(memory_order_relaxed) == 0; }
+        void await_suspend(coroutine_handle<> coroutine) { scheduler->enqueue(coroutine, true); }
+        void await_resume() const noexcept {}
+    };
+    
+    /**
+     * Start a scheduler
+     * @param threadCount Number of worker threads
+     */
+    explicit CoroutineScheduler(unsigned threadCount) {
+        for (unsigned i = 0; i < max(1u, threadCount); i++) {
+            threads.emplace_back(&CoroutineScheduler::workerLoop, this);
+        }
+    }
+    
+    /**
+     * Stop once every queued coroutine has run; coroutines suspended on anything
+     * other than the scheduler must have finished first
+     */
+    ~CoroutineScheduler() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& t : threads) {
+            t.join();
+        }
+    }
+    
+    CoroutineScheduler(const CoroutineScheduler&) = delete;
+    CoroutineScheduler& operator=(const CoroutineScheduler&) = delete;
+    
+    ScheduleAwaiter schedule() {
+        return ScheduleAwaiter{*this};
+    }
+    
+    YieldAwaiter yield() {
+        return YieldAwaiter{this};
+    }
+    
+    /**
+     * Run a task on the pool without waiting for it; it must not throw
+     * @param task Task to run
+     */
+    void spawn(Task<void> task) {
+        runDetached(*this, move(task));
+    }
+};
+
+
+/**
+ * Yield Budget
+ *
+ * Meters the work of a long-running coroutine and yields to its scheduler each
+ * time an interval's worth has been done. Without a scheduler it never suspends,
+ * so the same query code also runs synchronously.
+ */
+class YieldBudget {
+private:
+    CoroutineScheduler* scheduler; // Scheduler to yield to, may be null
+    size_t interval; // Units of work between yields
+    size_t spent = 0; // Units of work since the last yield
+    
+public:
+    static const size_t DEFAULT_INTERVAL = 1024;
+    
+    /**
+     * Create a budget
+     * @param owner Scheduler running the coroutine, null if it runs synchronously
+     * @param units Units of work between yields
+     */
+    explicit YieldBudget(CoroutineScheduler* owner, size_t units = DEFAULT_INTERVAL)
+        : scheduler(owner), interval(max<size_t>(1, units)) {}
+    
+    /**
+     * Record work done, yielding if the interval is used up: co_await budget.spend(n)
+     * @param units Units of work done
+     * @return Awaitable that suspends only when a yield is due and work is waiting
+     */
+    CoroutineScheduler::YieldAwaiter spend(size_t units = 1) {
+        spent += units;
+        if (spent < interval) return CoroutineScheduler::YieldAwaiter{nullptr};
+        spent = 0;
+        return CoroutineScheduler::YieldAwaiter{scheduler};
+    }
+};
+
+
+/**
+ * Custom Merge Sort Implementation
+ *
+ * Enhancement: Generic stable O(n log n) sort over any random-access range
+ *
+ * - Guaranteed O(n log n) time complexity in all cases
+ * - Stable sorting (maintains relative order of equal elements)
+ * - Predictable performance regardless of input data distribution
+ *
+ * std::sort (introsort) is also O(n log n) in the worst case, since it falls back
+ * to heapsort, but it is not stable. The stable alternative, std::stable_sort, is
+ * what this class competes with; run the sort-compare benchmark to see how the two
+ * and std::sort compare on this machine.
+ *
+ * sort is templated over the iterator, comparator and projection, and picks its
+ * kernels at compile time: branchless merges when elements are small and
+ * trivially copyable, and 8-element sorting networks for integers under the
+ * default ordering. The Course overloads below are thin wrappers over it, and
+ * parallelSort forks the same algorithm across a work-stealing pool.
+ */
+class MergeSort {
+public:
+    /**
+     * Projection that returns the element itself
+     */
+    struct Identity {
+        template <typename T>
+        constexpr T&& operator()(T&& value) const noexcept {
+            return std::forward<T>(value);
+        }
+    };
+    
+    /**
+     * Stable bottom-up merge sort of a random-access range
+     *
+     * Elements are ordered by comp(proj(a), proj(b)), so a member pointer such as
+     * &Course::courseNumber sorts by that field without a custom comparator.
+     *
+     * @param first Start of the range
+     * @param last End of the range
+     * @param comp Strict weak ordering over projected keys
+     * @param proj Callable mapping an element to its sort key
+     * Time Complexity: O(n log n) guaranteed
+     * Space Complexity: O(n) for one scratch buffer
+     */
+    template <typename Iterator, typename Compare = less<>, typename Projection = Identity>
+    static void sort(Iterator first, Iterator last, Compare comp = Compare(), Projection proj = Projection()) {
+        typedef typename iterator_traits<Iterator>::value_type Value;
+        vector<Value> buffer(last - first);
+        sortWithBuffer(first, last, buffer.begin(), comp, proj);
+    }
+    
+    /**
+     * Stable bottom-up merge sort using caller-provided scratch space
+     *
+     * Short runs are sorted first (by a sorting network or insertion sort), then
+     * merged pairwise with doubling width, ping-ponging between the range and the
+     * buffer so every pass moves each element exactly once.
+     *
+     * @param first Start of the range
+     * @param last End of the range
+     * @param buffer Start of scratch space at least as long as the range
+     * @param comp Strict weak ordering over projected keys
+     * @param proj Callable mapping an element to its sort key
+     */
+    template <typename Iterator, typename BufferIterator, typename Compare, typename Projection>
+    static void sortWithBuffer(Iterator first, Iterator last, BufferIterator buffer, Compare comp, Projection proj) {
+        size_t n = last - first;
+        size_t width = sortShortRuns(first, n, comp, proj);
+        bool inBuffer = false;
+        
+        for(; width < n; width *= 2) {
+            for(size_t left = 0; left < n; left += 2 * width) {
+                size_t mid = min(n, left + width);
+                size_t right = min(n, left + 2 * width);
+                if(inBuffer) {
+                    mergeRuns(buffer + left, buffer + mid, buffer + right, first + left, comp, proj);
+                } else {
+                    mergeRuns(first + left, first + mid, first + right, buffer + left, comp, proj);
+                }
+            }
+            inBuffer = !inBuffer;
+        }
+        
+        if(inBuffer) {
+            move(buffer, buffer + n, first);
+        }
+    }
+    
+    /**
+     * Iterative bottom-up merge sort by course number
+     *
+     * Courses are moved, never copied, and the single scratch buffer is allocated
+     * once. Ties keep their input order, giving the same result as mergeSort.
+     *
+     * @param courses Vector of courses to sort
+     * Time Complexity: O(n log n) guaranteed
+     * Space Complexity: O(n) for the single scratch buffer
+     */
+    static void bottomUpSort(vector<Course>& courses) {
+        sort(courses.begin(), courses.end(), less<>(), &Course::courseNumber);
+    }
+    
+    /**
+     * Parallel merge sort by course number on a work-stealing pool
+     *
+     * Recursive halves above PARALLEL_CUTOFF courses are forked as pool tasks;
+     * smaller ranges fall back to bottomUpSortRange. Halves are sorted into the
+     * opposite array of a single scratch buffer and merged back with a parallel
+     * merge that splits the larger run at its midpoint and finds the matching split
+     * in the other run by binary search. The result is stable, so it is identical to
+     * mergeSort regardless of thread count or scheduling.
+     *
+     * @param courses Vector of courses to sort
+     * @param threadCount Threads to sort with (including the caller), 0 for workerCount()
+     * Time Complexity: O(n log n) work, O(log^3 n) span
+     * Space Complexity: O(n) for the single scratch buffer
+     */
+    static void parallelSort(vector<Course>& courses, unsigned threadCount = 0) {
+        if(threadCount == 0) threadCount = workerCount();
+        vector<Course> buffer(courses.size());
+        if(threadCount <= 1 || courses.size() <= PARALLEL_CUTOFF) {
+            bottomUpSortRange(courses, buffer, 0, courses.size());
+            return;
+        }
+        
+        WorkStealingPool pool(threadCount - 1);
+        TaskGroup root(pool);
+        root.run([&]() { parallelSortRange(pool, courses, buffer, 0, courses.size(), true); });
+        root.wait();
+    }
+    
+    /**
+     * Order a catalog by course number without moving any Course
+     *
+     * Sorts compact (key, record ID) pairs, where the key packs the first eight
+     * bytes of the course number big-endian, so most comparisons are a single
+     * integer compare. Only keys with an equal eight-byte prefix fall back to
+     * comparing the full strings. Ties keep record order, matching the stable
+     * ordering of mergeSort.
+     *
+     * @param table Catalog to order
+     * @return View over the catalog in course number order
+     * Time Complexity: O(n log n)
+     * Space Complexity: O(n) for 16-byte keys
+     */
+    static CourseOrdering orderByNumber(const CourseHashTable& table) {
+        vector<CourseSortKey> keys;
+        keys.reserve(table.size());
+        for (size_t id = 0; id < table.recordCount(); id++) {
+            if (table.isRemoved(id)) continue;
+            const string& number = table.getCourse(id).courseNumber;
+            uint64_t key = 0;
+            for (size_t b = 0; b < 8; b++) {
+                key = (key << 8) | (b < number.size() ? (unsigned char)number[b] : 0);
+            }
+            keys.push_back({key, (uint32_t)id});
+        }
+        
+        sort(keys.begin(), keys.end(), [&table](const CourseSortKey& a, const CourseSortKey& b) {
+            if (a.key != b.key) return a.key < b.key;
+            const string& numberA = table.getCourse(a.id).courseNumber;
+            const string& numberB = table.getCourse(b.id).courseNumber;
+            if (numberA != numberB) return numberA < numberB;
+            return a.id < b.id;
+        });
+        
+        vector<uint32_t> ids(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            ids[i] = keys[i].id;
+        }
+        return CourseOrdering(table, move(ids));
+    }
+    
+    /**
+     * Public interface for merge sort
+     * @param courses Vector of courses to sort
+     * @param left Starting index
+     * @param right Ending index
+     * Time Complexity: O(n log n) guaranteed
+     * Space Complexity: O(n) for the scratch buffer
+     */
+    static void mergeSort(vector<Course>& courses, int left, int right) {
+        if(left < right) {
+            sort(courses.begin() + left, courses.begin() + right + 1, less<>(), &Course::courseNumber);
+        }
+    }
+    
+private:
+    static constexpr size_t INSERTION_RUN = 32; // Runs insertion-sorted before merging
+    static constexpr size_t NETWORK_RUN = 8; // Runs sorted by a sorting network before merging
+    static constexpr size_t PARALLEL_CUTOFF = 1 << 14; // Smallest range worth forking
+    static constexpr size_t PARALLEL_MERGE_CUTOFF = 1 << 13; // Smallest merge worth splitting
+    
+    /**
+     * Bottom-up merge sort of one range by course number, with the result left in courses
+     * @param courses Vector holding the range to sort
+     * @param buffer Scratch vector at least as large as courses
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     */
+    static void bottomUpSortRange(vector<Course>& courses, vector<Course>& buffer, size_t begin, size_t end) {
+        sortWithBuffer(courses.begin() + begin, courses.begin() + end, buffer.begin() + begin,
+                       less<>(), &Course::courseNumber);
+    }
+    
+    /**
+     * Sort one range in parallel, leaving the result in either array
+     * @param pool Pool to fork tasks on
+     * @param courses Vector holding the unsorted range
+     * @param buffer Scratch vector of the same size
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     * @param intoCourses true to leave the sorted range in courses, false for buffer
+     */
+    static void parallelSortRange(WorkStealingPool& pool, vector<Course>& courses, vector<Course>& buffer,
+                                  size_t begin, size_t end, bool intoCourses) {
+        if(end - begin <= PARALLEL_CUTOFF) {
+            bottomUpSortRange(courses, buffer, begin, end);
+            if(!intoCourses) {
+                move(courses.begin() + begin, courses.begin() + end, buffer.begin() + begin);
+            }
+            return;
+        }
+        
+        // Sort both halves into the other array, then merge them into the requested one
+        size_t mid = begin + (end - begin) / 2;
+        TaskGroup halves(pool);
+        halves.run([&]() { parallelSortRange(pool, courses, buffer, begin, mid, !intoCourses); });
+        parallelSortRange(pool, courses, buffer, mid, end, !intoCourses);
+        halves.wait();
+        
+        vector<Course>& source = intoCourses ? buffer : courses;
+        vector<Course>& target = intoCourses ? courses : buffer;
+        parallelMerge(pool, source, target, begin, mid, mid, end, begin);
+    }
+    
+    /**
+     * Stable parallel merge of two sorted runs by recursive binary-search splitting
+     * @param pool Pool to fork tasks on
+     * @param source Vector holding both runs
+     * @param target Vector receiving the merged output
+     * @param leftBegin Start of the left (earlier) run
+     * @param leftEnd End of the left run
+     * @param rightBegin Start of the right run
+     * @param rightEnd End of the right run
+     * @param out Index in target where the merged output starts
+     */
+    static void parallelMerge(WorkStealingPool& pool, vector<Course>& source, vector<Course>& target,
+                              size_t leftBegin, size_t leftEnd, size_t rightBegin, size_t rightEnd, size_t out) {
+        size_t leftSize = leftEnd - leftBegin;
+        size_t rightSize = rightEnd - rightBegin;
+        
+        if(leftSize + rightSize <= PARALLEL_MERGE_CUTOFF) {
+            size_t i = leftBegin, j = rightBegin;
+            while(i < leftEnd && j < rightEnd) {
+                if(source[i].courseNumber <= source[j].courseNumber) {
+                    target[out++] = move(source[i++]);
+                } else {
+                    target[out++] = move(source[j++]);
+                }
+            }
+            while(i < leftEnd) target[out++] = move(source[i++]);
+            while(j < rightEnd) target[out++] = move(source[j++]);
+            return;
+        }
+        
+        auto byNumber = [](const Course& a, const Course& b) { return a.courseNumber < b.courseNumber; };
+        size_t leftSplit, rightSplit;
+        if(leftSize >= rightSize) {
+            // Right elements equal to the pivot must stay after it, so split below them
+            leftSplit = leftBegin + leftSize / 2;
+            rightSplit = lower_bound(source.begin() + rightBegin, source.begin() + rightEnd,
+                                     source[leftSplit], byNumber) - source.begin();
+        } else {
+            // Left elements equal to the pivot must stay before it, so split above them
+            rightSplit = rightBegin + rightSize / 2;
+            leftSplit = upper_bound(source.begin() + leftBegin, source.begin() + leftEnd,
+                                    source[rightSplit], byNumber) - source.begin();
+        }
+        
+        size_t upperOut = out + (leftSplit - leftBegin) + (rightSplit - rightBegin);
+        TaskGroup parts(pool);
+        parts.run([&]() { parallelMerge(pool, source, target, leftBegin, leftSplit, rightBegin, rightSplit, out); });
+        parallelMerge(pool, source, target, leftSplit, leftEnd, rightSplit, rightEnd, upperOut);
+        parts.wait();
+    }
+    
+    /**
+     * Check at compile time if short runs can use sorting networks
+     *
+     * Networks are not stable, so they are only used where equal elements are
+     * indistinguishable: integers sorted by value in ascending order.
+     *
+     * @return true if Value, Compare and Projection qualify
+     */
+    template <typename Value, typename Compare, typename Projection>
+    static constexpr bool usesSortingNetwork() {
+        return is_integral<Value>::value && is_same<Projection, Identity>::value &&
+               (is_same<Compare, less<>>::value || is_same<Compare, less<Value>>::value);
+    }
+    
+    /**
+     * Check at compile time if merges can select elements without branching
+     * @return true if elements are small and trivially copyable
+     */
+    template <typename Value>
+    static constexpr bool usesBranchlessMerge() {
+        return is_trivially_copyable<Value>::value && sizeof(Value) <= 16;
+    }
+    
+    /**
+     * Sort eight integers in place with Batcher's 19-comparator network
+     * @param first Start of the eight elements
+     */
+    template <typename Iterator>
+    static void sortingNetwork8(Iterator first) {
+        static const int PAIRS[19][2] = {
+            {0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {1, 2}, {5, 6},
+            {0, 4}, {3, 7}, {1, 5}, {2, 6}, {1, 4}, {3, 6}, {2, 4}, {3, 5}, {3, 4}
+        };
+        for(const auto& pair : PAIRS) {
+            auto a = first[pair[0]];
+            auto b = first[pair[1]];
+            first[pair[0]] = min(a, b);
+            first[pair[1]] = max(a, b);
+        }
+    }
+    
+    /**
+     * Stable insertion sort of a short range
+     * @param first Start of the range
+     * @param last End of the range
+     * @param comp Strict weak ordering over projected keys
+     * @param proj Callable mapping an element to its sort key
+     */
+    template <typename Iterator, typename Compare, typename Projection>
+    static void insertionSort(Iterator first, Iterator last, Compare& comp, Projection& proj) {
+        for(Iterator it = first + (first != last); it < last; ++it) {
+            if(!invoke(comp, invoke(proj, *it), invoke(proj, *(it - 1)))) continue;
+            
+            auto current = move(*it);
+            Iterator hole = it;
+            while(hole > first && invoke(comp, invoke(proj, current), invoke(proj, *(hole - 1)))) {
+                *hole = move(*(hole - 1));
+                --hole;
+            }
+            *hole = move(current);
+        }
+    }
+    
+    /**
+     * Sort consecutive short runs in place, choosing the kernel at compile time
+     * @param first Start of the range
+     * @param n Number of elements in the range
+     * @param comp Strict weak ordering over projected keys
+     * @param proj Callable mapping an element to its sort key
+     * @return Length of the sorted runs
+     */
+    template <typename Iterator, typename Compare, typename Projection>
+    static size_t sortShortRuns(Iterator first, size_t n, Compare& comp, Projection& proj) {
+        typedef typename iterator_traits<Iterator>::value_type Value;
+        size_t run = usesSortingNetwork<Value, Compare, Projection>() ? NETWORK_RUN : INSERTION_RUN;
+        
+        for(size_t start = 0; start < n; start += run) {
+            if constexpr (usesSortingNetwork<Value, Compare, Projection>()) {
+                if(start + NETWORK_RUN <= n) {
+                    sortingNetwork8(first + start);
+                    continue;
+                }
+            }
+            insertionSort(first + start, first + min(n, start + run), comp, proj);
+        }
+        return run;
+    }
+    
+    /**
+     * Stable merge of two adjacent sorted runs into another range
+     *
+     * Small trivially copyable elements are selected with a conditional move and
+     * both cursors advanced arithmetically, so the loop has no data-dependent
+     * branch for the predictor to miss. Other elements use the usual branching
+     * merge with moves. Runs that are already in order, or entirely reversed, are
+     * moved across after two comparisons.
+     *
+     * @param left Start of the first run
+     * @param mid End of the first run and start of the second
+     * @param right End of the second run
+     * @param out Start of the output range
+     * @param comp Strict weak ordering over projected keys
+     * @param proj Callable mapping an element to its sort key
+     */
+    template <typename InputIterator, typename OutputIterator, typename Compare, typename Projection>
+    static void mergeRuns(InputIterator left, InputIterator mid, InputIterator right, OutputIterator out,
+                          Compare& comp, Projection& proj) {
+        typedef typename iterator_traits<InputIterator>::value_type Value;
+        InputIterator i = left, j = mid;
+        
+        if(i == mid || j == right || !invoke(comp, invoke(proj, *j), invoke(proj, *(mid - 1)))) {
+            move(left, right, out); // Runs already in order
+            return;
+        }
+        if(invoke(comp, invoke(proj, *(right - 1)), invoke(proj, *left))) {
+            move(left, mid, move(mid, right, out)); // Runs in reverse order
+            return;
+        }
+        
+        if constexpr (usesBranchlessMerge<Value>()) {
+            while(i < mid && j < right) {
+                bool takeRight = invoke(comp, invoke(proj, *j), invoke(proj, *i));
+                *out++ = takeRight ? *j : *i;
+                j += takeRight;
+                i += !takeRight;
+            }
+        } else {
+            while(i < mid && j < right) {
+                if(invoke(comp, invoke(proj, *j), invoke(proj, *i))) {
+                    *out++ = move(*j++);
+                } else {
+                    *out++ = move(*i++);
+                }
+            }
+        }
+        
+        out = move(i, mid, out);
+        move(j, right, out);
+    }
+};
+
+
+/**
+ * Natural-Order Radix Sort
+ *
+ * Orders courses the way a catalog lists them: by department, then by the
+ * numeric part of the course number, so CSCI200 comes before CSCI1000.
+ *
+ * Each course number is split once into fixed-width integer keys, which are then
+ * sorted with a byte-wise LSD radix sort. No strings are compared, and every pass
+ * is a linear counting pass; passes over bytes that are the same for every key
+ * are skipped.
+ *
+ * Keys are truncated (see extractKey), so course numbers that differ only past
+ * the truncation, such as D12_1050 and D12_1051 (suffixes cut to "_105"), get
+ * equal keys. Those ties are broken on the whole course number (see tieKey); the
+ * sorted indexes and the external sort break them the same way.
+ */
+class RadixSort {
+public:
+    /**
+     * Fixed-width natural sort key of one course
+     */
+    struct NaturalKey {
+        uint64_t department; // Up to 8 leading non-digit characters, uppercased, big-endian
+        uint64_t numberAndSuffix; // Numeric part in the high 32 bits, up to 4 suffix characters in the low
+        uint32_t id; // Record ID of the course
+    };
+    
+    /**
+     * Split a course number into its natural sort key
+     *
+     * "CSCI1000L" becomes department "CSCI", number 1000 and suffix "L". Departments
+     * longer than 8 characters and suffixes longer than 4 are truncated, and numbers
+     * too large for 32 bits are clamped.
+     *
+     * @param courseNumber Course number to split
+     * @param id Record ID to carry with the key
+     * @return Natural sort key
+     */
+    static NaturalKey extractKey(const string& courseNumber, uint32_t id) {
+        size_t i = 0;
+        uint64_t department = 0;
+        for(int b = 0; b < 8; b++) {
+            unsigned char c = 0;
+            if(i < courseNumber.size() && !isdigit((unsigned char)courseNumber[i])) {
+                c = (unsigned char)toupper((unsigned char)courseNumber[i++]);
+            }
+            department = (department << 8) | c;
+        }
+        while(i < courseNumber.size() && !isdigit((unsigned char)courseNumber[i])) i++;
+        
+        uint64_t number = 0;
+        for(; i < courseNumber.size() && isdigit((unsigned char)courseNumber[i]); i++) {
+            number = min<uint64_t>(number * 10 + (courseNumber[i] - '0'), UINT32_MAX);
+        }
+        
+        uint64_t suffix = 0;
+        for(int b = 0; b < 4; b++) {
+            unsigned char c = (i < courseNumber.size()) ? (unsigned char)toupper((unsigned char)courseNumber[i++]) : 0;
+            suffix = (suffix << 8) | c;
+        }
+        
+        return {department, (number << 32) | suffix, id};
+    }
+    
+    /**
+     * Get the tie-breaker for course numbers with equal natural keys
+     * @param courseNumber Course number
+     * @return The whole course number, uppercased like the key
+     */
+    static string tieKey(string courseNumber) {
+        transform(courseNumber.begin(), courseNumber.end(), courseNumber.begin(), ::toupper);
+        return courseNumber;
+    }
+    
+    /**
+     * Re-order the runs of equal keys left by sortKeys by their whole course numbers
+     * @param keys Keys sorted by sortKeys
+     * @param courseNumber Maps the ID carried by a key to its course number
+     * Time Complexity: O(n), plus sorting each run of tied keys
+     */
+    template <typename CourseNumberOf>
+    static void breakTies(vector<NaturalKey>& keys, CourseNumberOf courseNumber) {
+        size_t first = 0;
+        for(size_t i = 1; i <= keys.size(); i++) {
+            if(i < keys.size() && keys[i].department == keys[first].department &&
+               keys[i].numberAndSuffix == keys[first].numberAndSuffix) continue;
+            
+            if(i - first > 1) {
+                MergeSort::sort(keys.begin() + first, keys.begin() + i, less<>(),
+                                [&](const NaturalKey& key) { return tieKey(courseNumber(key.id)); });
+            }
+            first = i;
+        }
+    }
+    
+    /**
+     * LSD radix sort of natural keys, least significant byte first
+     * @param keys Keys to sort
+     * Time Complexity: O(16 * (n + 256))
+     * Space Complexity: O(n) for one scratch buffer
+     */
+    static void sortKeys(vector<NaturalKey>& keys) {
+        const int PASSES = 16;
+        size_t n = keys.size();
+        vector<array<size_t, 256>> counts(PASSES);
+        for(auto& count : counts) count.fill(0);
+        
+        // One histogram sweep for all passes
+        for(const NaturalKey& key : keys) {
+            for(int pass = 0; pass < PASSES; pass++) {
+                counts[pass][keyByte(key, pass)]++;
+            }
+        }
+        
+        vector<NaturalKey> buffer(n);
+        vector<NaturalKey>* source = &keys;
+        vector<NaturalKey>* target = &buffer;
+        
+        for(int pass = 0; pass < PASSES; pass++) {
+            array<size_t, 256>& count = counts[pass];
+            if(n == 0 || count[keyByte((*source)[0], pass)] == n) continue;
+            
+            size_t offset = 0;
+            for(size_t& bucket : count) {
+                size_t size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+            for(const NaturalKey& key : *source) {
+                (*target)[count[keyByte(key, pass)]++] = key;
+            }
+            swap(source, target);
+        }
+        
+        if(source != &keys) {
+            keys.swap(buffer);
+        }
+    }
+    
+    /**
+     * Order a catalog in natural course number order
+     * @param table Catalog to order
+     * @return View over the catalog by department, then numeric course number
+     * Time Complexity: O(n)
+     */
+    static CourseOrdering orderNaturally(const CourseHashTable& table) {
+        vector<NaturalKey> keys;
+        keys.reserve(table.size());
+        for(size_t id = 0; id < table.recordCount(); id++) {
+            if(table.isRemoved(id)) continue;
+            keys.push_back(extractKey(table.getCourse(id).courseNumber, (uint32_t)id));
+        }
+        sortKeys(keys);
+        breakTies(keys, [&](uint32_t id) -> const string& { return table.getCourse(id).courseNumber; });
+        
+        vector<uint32_t> ids(keys.size());
+        for(size_t i = 0; i < keys.size(); i++) {
+            ids[i] = keys[i].id;
+        }
+        return CourseOrdering(table, move(ids));
+    }
+    
+private:
+    /**
+     * Get one byte of a key, pass 0 being the least significant
+     * @param key Key to read
+     * @param pass Byte index from 0 (lowest suffix byte) to 15 (first department character)
+     * @return Byte value
+     */
+    static unsigned keyByte(const NaturalKey& key, int pass) {
+        return (pass < 8) ? (key.numberAndSuffix >> (8 * pass)) & 0xFF : (key.department >> (8 * (pass - 8))) & 0xFF;
+    }
+};
+
+
+/**
+ * External Merge Sort
+ *
+ * Sorts catalog lines that do not fit in memory into natural course number order.
+ *
+ * Lines are read into an in-memory run until the memory budget is reached; the run
+ * is sorted by natural key and spilled to an unlinked temporary file (under
+ * $TMPDIR, or /tmp). The runs are then merged k ways through a loser tree, which
+ * finds the next line with one comparison per tree level. When there are more runs
+ * than the budget can buffer at once, consecutive runs are merged in extra passes.
+ * Equal keys are ordered by whole course number, as with RadixSort, and ties
+ * between runs then go to the earlier run, so lines for the same course keep
+ * their input order. A catalog that fits in one run never touches the disk.
+ *
+ * Run records are the two 64-bit natural key words, a 32-bit line length and the
+ * line bytes.
+ */
+class ExternalSort {
+public:
+    /**
+     * Counters describing one sort
+     */
+    struct Stats {
+        size_t lines = 0; // Lines sorted
+        size_t runs = 0; // Runs spilled to temporary files
+        size_t mergePasses = 0; // Merge passes over the runs, 0 if nothing was spilled
+    };
+    
+    /**
+     * Sort catalog lines by natural course number
+     *
+     * Reading stops at end of input or a "-1" line, and blank lines are skipped.
+     *
+     * @param input Stream of catalog lines
+     * @param memoryBudget Approximate bytes of memory to use for runs and merge buffers
+     * @param emit Called with each line in sorted order
+     * @param stats Filled in with counters for the sort
+     * @param error Set to the reason when the sort fails
+     * @return false if a temporary file could not be created, written or read back
+     */
+    static bool sortLines(istream& input, size_t memoryBudget, const function<void(const string&)>& emit, Stats& stats,
+                          string& error) {
+        stats = Stats();
+        memoryBudget = max(memoryBudget, MIN_BUFFER * 2);
+        
+        vector<FILE*> runs;
+        RunBuilder run;
+        string line;
+        bool ok = true;
+        
+        while(ok && getline(input, line)) {
+            if(line == "-1") break;
+            if(line.empty()) continue;
+            
+            if(!run.entries.empty() && run.bytesAfter(line) > memoryBudget) {
+                ok = spill(run, runs);
+            }
+            run.add(line);
+            stats.lines++;
+        }
+        
+        if(ok && runs.empty()) {
+            // Everything fit in memory: emit the single run directly
+            run.sort();
+            for(const RunEntry& entry : run.entries) {
+                emit(run.arena.substr(entry.offset, entry.length));
+            }
+            return true;
+        }
+        if(ok && !run.entries.empty()) {
+            ok = spill(run, runs);
+        }
+        stats.runs = runs.size();
+        
+        // Each open run gets one read buffer; keep one buffer's worth for output
+        size_t fanIn = max<size_t>(2, min<size_t>(MAX_FAN_IN, memoryBudget / MIN_BUFFER - 1));
+        while(ok && runs.size() > fanIn) {
+            vector<FILE*> merged;
+            for(size_t first = 0; ok && first < runs.size(); first += fanIn) {
+                vector<FILE*> group(runs.begin() + first, runs.begin() + min(runs.size(), first + fanIn));
+                FILE* target = openTemporaryFile();
+                ok = target != nullptr;
+                if(ok) {
+                    setvbuf(target, nullptr, _IOFBF, MIN_BUFFER);
+                    ok = mergeRuns(group, memoryBudget / (group.size() + 1), [&](const RunRecord& record) {
+                        return writeRecord(target, record.key, record.line);
+                    });
+                    ok = ok && fflush(target) == 0;
+                    merged.push_back(target);
+                }
+                for(FILE* file : group) fclose(file);
+                fill(runs.begin() + first, runs.begin() + min(runs.size(), first + fanIn), nullptr);
+            }
+            for(FILE* file : runs) {
+                if(file) fclose(file);
+            }
+            runs.swap(merged);
+            stats.mergePasses++;
+        }
+        
+        if(ok) {
+            ok = mergeRuns(runs, memoryBudget / (runs.size() + 1), [&](const RunRecord& record) {
+                emit(record.line);
+                return true;
+            });
+            stats.mergePasses++;
+        }
+        
+        int failure = ok ? 0 : errno;
+        for(FILE* file : runs) fclose(file);
+        if(!ok) {
+            error = failure ? strerror(failure) : "a run file ended early";
+        }
+        return ok;
+    }
+    
+private:
+    static constexpr size_t MIN_BUFFER = 64 * 1024; // Smallest read buffer given to one run
+    static constexpr size_t MAX_FAN_IN = 256; // Most runs merged at once, to bound open files
+    
+    typedef pair<uint64_t, uint64_t> Key; // Natural key: department, then number and suffix
+    
+    /**
+     * Check if one line sorts before another with the same natural key
+     * @return true if the first line's whole course number sorts first
+     */
+    static bool tieLess(const string& a, const string& b) {
+        return RadixSort::tieKey(a.substr(0, a.find(','))) < RadixSort::tieKey(b.substr(0, b.find(',')));
+    }
+    
+    /**
+     * One line of an in-memory run
+     */
+    struct RunEntry {
+        Key key;
+        size_t offset; // Start of the line in the run's arena
+        uint32_t length; // Length of the line
+    };
+    
+    /**
+     * Lines of the run being built, stored back to back in one arena
+     */
+    struct RunBuilder {
+        string arena;
+        vector<RunEntry> entries;
+        
+        /**
+         * Memory the run would use with one more line, counting the sort's scratch entries
+         * @param line Line to be added
+         * @return Approximate bytes
+         */
+        size_t bytesAfter(const string& line) const {
+            return arena.size() + line.size() + (entries.size() + 1) * 2 * sizeof(RunEntry);
+        }
+        
+        void add(const string& line) {
+            RadixSort::NaturalKey key = RadixSort::extractKey(line.substr(0, line.find(',')), 0);
+            entries.push_back({Key(key.department, key.numberAndSuffix), arena.size(), (uint32_t)line.size()});
+            arena += line;
+        }
+        
+        void sort() {
+            MergeSort::sort(entries.begin(), entries.end(), [this](const RunEntry& a, const RunEntry& b) {
+                if(a.key != b.key) return a.key < b.key;
+                return tieLess(arena.substr(a.offset, a.length), arena.substr(b.offset, b.length));
+            });
+        }
+        
+        void clear() {
+            arena.clear();
+            entries.clear();
+        }
+    };
+    
+    /**
+     * Current record of a run being merged
+     */
+    struct RunRecord {
+        Key key;
+        string line;
+        bool exhausted = false;
+    };
+    
+    /**
+     * Create a temporary file that is removed as soon as it is closed
+     * @return Open file, or nullptr on failure
+     */
+    static FILE* openTemporaryFile() {
+        const char* directory = getenv("TMPDIR");
+        string path = string((directory && *directory) ? directory : "/tmp") + "/course-planner-run-XXXXXX";
+        int fd = mkstemp(&path[0]);
+        if(fd < 0) return nullptr;
+        unlink(path.c_str());
+        
+        FILE* file = fdopen(fd, "w+b");
+        if(!file) close(fd);
+        return file;
+    }
+    
+    /**
+     * Append one record to a run file
+     * @return false on a write error
+     */
+    static bool writeRecord(FILE* file, const Key& key, const string& line) {
+        uint64_t words[2] = {key.first, key.second};
+        uint32_t length = (uint32_t)line.size();
+        return fwrite(words, sizeof(words), 1, file) == 1 &&
+               fwrite(&length, sizeof(length), 1, file) == 1 &&
+               fwrite(line.data(), 1, line.size(), file) == line.size();
+    }
+    
+    /**
+     * Read the next record of a run file
+     * @param record Filled in, or marked exhausted at end of file
+     * @return false on a read error or truncated record
+     */
+    static bool readRecord(FILE* file, RunRecord& record) {
+        uint64_t words[2];
+        uint32_t length;
+        if(fread(words, sizeof(words), 1, file) != 1) {
+            record.exhausted = true;
+            return !ferror(file);
+        }
+        if(fread(&length, sizeof(length), 1, file) != 1) return false;
+        
+        record.key = Key(words[0], words[1]);
+        record.line.resize(length);
+        return fread(&record.line[0], 1, length, file) == length;
+    }
+    
+    /**
+     * Sort the run being built and write it to a new temporary file
+     * @param run Run to spill, cleared afterwards
+     * @param runs Open run files, in input order
+     * @return false if the file could not be created or written
+     */
+    static bool spill(RunBuilder& run, vector<FILE*>& runs) {
+        FILE* file = openTemporaryFile();
+        if(!file) return false;
+        runs.push_back(file);
+        setvbuf(file, nullptr, _IOFBF, MIN_BUFFER);
+        
+        run.sort();
+        for(const RunEntry& entry : run.entries) {
+            if(!writeRecord(file, entry.key, run.arena.substr(entry.offset, entry.length))) return false;
+        }
+        run.clear();
+        return fflush(file) == 0;
+    }
+    
+    /**
+     * Merge sorted run files through a loser tree
+     *
+     * Internal node t of the tree holds the run that lost the match played there,
+     * and node 0 holds the overall winner. After the winner's record is emitted,
+     * only the matches on the path from its leaf to the root are replayed.
+     *
+     * @param runs Run files in input order; each is rewound before reading
+     * @param bufferSize Read buffer size for each run
+     * @param emit Called with each record in order; returning false stops the merge
+     * @return false on a read error or if emit failed
+     */
+    static bool mergeRuns(const vector<FILE*>& runs, size_t bufferSize, const function<bool(const RunRecord&)>& emit) {
+        size_t k = runs.size();
+        vector<RunRecord> heads(k);
+        for(size_t i = 0; i < k; i++) {
+            rewind(runs[i]);
+            setvbuf(runs[i], nullptr, _IOFBF, max(bufferSize, MIN_BUFFER));
+            if(!readRecord(runs[i], heads[i])) return false;
+        }
+        
+        // -1 stands for a run that beats every other, so the first k replays fill the tree
+        auto beats = [&](long a, long b) {
+            if(a < 0 || b < 0) return a < 0;
+            if(heads[a].exhausted != heads[b].exhausted) return heads[b].exhausted;
+            if(heads[a].key != heads[b].key) return heads[a].key < heads[b].key;
+            if(tieLess(heads[a].line, heads[b].line)) return true;
+            if(tieLess(heads[b].line, heads[a].line)) return false;
+            return a < b;
+        };
+        vector<long> tree(k, -1);
+        auto replay = [&](long winner) {
+            for(size_t node = (winner + k) / 2; node > 0; node /= 2) {
+                if(beats(tree[node], winner)) swap(winner, tree[node]);
+            }
+            tree[0] = winner;
+        };
+        for(size_t i = k; i-- > 0;) {
+            replay((long)i);
+        }
+        
+        while(k > 0 && !heads[tree[0]].exhausted) {
+            long winner = tree[0];
+            if(!emit(heads[winner])) return false;
+            if(!readRecord(runs[winner], heads[winner])) return false;
+            replay(winner);
+        }
+        return true;
+    }
+};
+
+
+/**
+ * Sorted Index
+ *
+ * One maintained ordering of catalog record IDs, kept as a sorted array of
+ * (key, record ID) entries. Edits use ordered insertion: a binary search plus a
+ * shift of the entries after it, which keeps positions addressable in O(1) for
+ * listings. The key of each indexed record is remembered so an entry can be
+ * found again after the course itself has changed.
+ */
+template <typename Key>
+class SortedIndex {
+private:
+    vector<pair<Key, uint32_t>> entries; // Sorted by key, then record ID
+    vector<Key> recordKeys; // Record ID -> key it is indexed under
+    vector<char> indexed; // Record ID -> 1 if present in entries
+    
+public:
+    /**
+     * Replace the contents with a freshly sorted set of entries
+     * @param all Every (key, record ID) pair to index
+     * Time Complexity: O(n log n)
+     */
+    void build(vector<pair<Key, uint32_t>> all) {
+        sort(all.begin(), all.end());
+        recordKeys.clear();
+        indexed.clear();
+        for (const auto& entry : all) {
+            if (entry.second >= indexed.size()) {
+                recordKeys.resize(entry.second + 1);
+                indexed.resize(entry.second + 1, 0);
+            }
+            recordKeys[entry.second] = entry.first;
+            indexed[entry.second] = 1;
+        }
+        entries = move(all);
+    }
+    
+    /**
+     * Insert or re-key a record
+     * @param id Record ID
+     * @param key Key to index it under
+     * Time Complexity: O(log n) search plus O(n) shift
+     */
+    void insert(uint32_t id, const Key& key) {
+        erase(id);
+        if (id >= indexed.size()) {
+            recordKeys.resize(id + 1);
+            indexed.resize(id + 1, 0);
+        }
+        
+        pair<Key, uint32_t> entry(key, id);
+        entries.insert(lower_bound(entries.begin(), entries.end(), entry), entry);
+        recordKeys[id] = key;
+        indexed[id] = 1;
+    }
+    
+    /**
+     * Remove a record if it is indexed
+     * @param id Record ID
+     * Time Complexity: O(log n) search plus O(n) shift
+     */
+    void erase(uint32_t id) {
+        if (id >= indexed.size() || !indexed[id]) return;
+        
+        auto it = lower_bound(entries.begin(), entries.end(), make_pair(recordKeys[id], id));
+        entries.erase(it);
+        indexed[id] = 0;
+    }
+    
+    /**
+     * Find where an entry is or would be, whether or not it is still indexed
+     * @param key Key of the entry
+     * @param id Record ID of the entry
+     * @return Position of the first entry ordered after (key, id)
+     * Time Complexity: O(log n)
+     */
+    size_t positionAfter(const Key& key, uint32_t id) const {
+        return upper_bound(entries.begin(), entries.end(), make_pair(key, id)) - entries.begin();
+    }
+    
+    /**
+     * Get the record ID at a position
+     * @param position Index into the ordering
+     * @return Record ID
+     */
+    uint32_t at(size_t position) const {
+        return entries[position].second;
+    }
+    
+    /**
+     * Get the key of the entry at a position
+     * @param position Index into the ordering
+     * @return Key of that entry
+     */
+    const Key& keyAt(size_t position) const {
+        return entries[position].first;
+    }
+    
+    /**
+     * Get the number of indexed records
+     * @return Entry count
+     */
+    size_t size() const {
+        return entries.size();
+    }
+};
+
+
+/**
+ * Maintained secondary orderings of the catalog
+ */
+enum class CatalogOrder {
+    Name, // Course name, case-insensitive
+    Department, // Department, then numeric course number
+    Level, // Course level, then department and number
+    PrerequisiteCount // Number of prerequisite courses, then department and number
+};
+
+
+/**
+ * Continuation point of a paginated catalog listing
+ *
+ * Holds the sort key and record ID of the last course returned rather than its
+ * position, so the next page starts right after that course even if courses were
+ * added or removed in between.
+ */
+struct CatalogCursor {
+    CatalogOrder order = CatalogOrder::Department; // Ordering being paged through
+    bool started = false; // false until the first page has been returned
+    bool finished = false; // true once the last page has been returned
+    string key; // Encoded sort key of the last course returned
+    uint32_t recordId = 0; // Record ID of the last course returned
+    
+    CatalogCursor() {}
+    explicit CatalogCursor(CatalogOrder listingOrder) : order(listingOrder) {}
+};
+
+
+/**
+ * Catalog Indexes
+ *
+ * Secondary sorted indexes over the courses in a CourseHashTable, kept current
+ * as courses are edited so every listing is served without re-sorting. Built on
+ * first use; level entries follow the graph's incremental level changes.
+ */
+class CatalogIndexes {
+private:
+    typedef tuple<uint64_t, uint64_t, string> NumberKey; // Natural department/number key, then RadixSort::tieKey
+    typedef tuple<int, uint64_t, uint64_t, string> RankKey; // Rank, then natural key
+    
+    SortedIndex<string> byName;
+    SortedIndex<NumberKey> byDepartment;
+    SortedIndex<RankKey> byLevel;
+    SortedIndex<RankKey> byPrerequisiteCount;
+    bool built = false; // Flag to track if the indexes have been built
+    
+    static string nameKey(const Course& course) {
+        string key = course.name;
+        transform(key.begin(), key.end(), key.begin(), ::tolower);
+        return key;
+    }
+    
+    static NumberKey numberKey(const Course& course) {
+        RadixSort::NaturalKey key = RadixSort::extractKey(course.courseNumber, 0);
+        return NumberKey(key.department, key.numberAndSuffix, RadixSort::tieKey(course.courseNumber));
+    }
+    
+    static RankKey rankKey(int rank, const Course& course) {
+        NumberKey number = numberKey(course);
+        return RankKey(rank, get<0>(number), get<1>(number), move(get<2>(number)));
+    }
+    
+    // Cursor encodings of each key type
+    static void appendWord(string& out, uint64_t word) {
+        for (int shift = 56; shift >= 0; shift -= 8) out += (char)((word >> shift) & 0xFF);
+    }
+    
+    static uint64_t readWord(const string& in, size_t offset) {
+        uint64_t word = 0;
+        for (size_t i = offset; i < offset + 8 && i < in.size(); i++) word = (word << 8) | (unsigned char)in[i];
+        return word;
+    }
+    
+    static string encodeKey(const string& key) {
+        return key;
+    }
+    
+    static string encodeKey(const NumberKey& key) {
+        string out;
+        appendWord(out, get<0>(key));
+        appendWord(out, get<1>(key));
+        return out + get<2>(key);
+    }
+    
+    static string encodeKey(const RankKey& key) {
+        string out;
+        appendWord(out, (uint64_t)(int64_t)get<0>(key));
+        appendWord(out, get<1>(key));
+        appendWord(out, get<2>(key));
+        return out + get<3>(key);
+    }
+    
+    static void decodeKey(const string& in, string& key) {
+        key = in;
+    }
+    
+    static void decodeKey(const string& in, NumberKey& key) {
+        key = NumberKey(readWord(in, 0), readWord(in, 8), in.size() > 16 ? in.substr(16) : "");
+    }
+    
+    static void decodeKey(const string& in, RankKey& key) {
+        key = RankKey((int)(int64_t)readWord(in, 0), readWord(in, 8), readWord(in, 16), in.size() > 24 ? in.substr(24) : "");
+    }
+    
+    /**
+     * Return the page of an index that follows a cursor, and advance the cursor
+     * @param table Catalog the index was built from
+     * @param index Index to page through
+     * @param cursor Continuation point, updated to the end of the returned page
+     * @param limit Maximum number of courses on the page
+     * @return View over the courses on the page
+     * Time Complexity: O(log n + limit)
+     */
+    template <typename Key>
+    static CourseOrdering pageAfter(const CourseHashTable& table, const SortedIndex<Key>& index,
+                                    CatalogCursor& cursor, size_t limit) {
+        size_t begin = 0;
+        if (cursor.started) {
+            Key key;
+            decodeKey(cursor.key, key);
+            begin = index.positionAfter(key, cursor.recordId);
+        }
+        size_t end = begin + min(limit, index.size() - begin);
+        
+        vector<uint32_t> ids(end - begin);
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids[i] = index.at(begin + i);
+        }
+        if (end > begin) {
+            cursor.started = true;
+            cursor.key = encodeKey(index.keyAt(end - 1));
+            cursor.recordId = index.at(end - 1);
+        }
+        cursor.finished = end == index.size();
+        return CourseOrdering(table, move(ids));
+    }
+    
+    /**
+     * Rebuild only the level index
+     * @param table Catalog holding the courses
+     * @param graph Graph providing the levels
+     */
+    void rebuildLevels(const CourseHashTable& table, PrerequisiteGraph& graph) {
+        vector<pair<RankKey, uint32_t>> levels;
+        for (size_t id = 0; id < table.recordCount(); id++) {
+            if (table.isRemoved(id)) continue;
+            const Course& course = table.getCourse(id);
+            levels.emplace_back(rankKey(graph.getCourseLevel(course.courseNumber), course), (uint32_t)id);
+        }
+        byLevel.build(move(levels));
+    }
+    
+public:
+    /**
+     * Check if the indexes have been built
+     * @return true if built
+     */
+    bool isBuilt() const {
+        return built;
+    }
+    
+    /**
+     * Drop the indexes; they are rebuilt on next use
+     */
+    void invalidate() {
+        built = false;
+    }
+    
+    /**
+     * Build every index from scratch
+     * @param table Catalog holding the courses
+     * @param graph Graph providing levels
+     * Time Complexity: O(n log n)
+     */
+    void rebuild(const CourseHashTable& table, PrerequisiteGraph& graph) {
+        vector<pair<string, uint32_t>> names;
+        vector<pair<NumberKey, uint32_t>> numbers;
+        vector<pair<RankKey, uint32_t>> counts;
+        
+        for (size_t id = 0; id < table.recordCount(); id++) {
+            if (table.isRemoved(id)) continue;
+            const Course& course = table.getCourse(id);
+            names.emplace_back(nameKey(course), (uint32_t)id);
+            numbers.emplace_back(numberKey(course), (uint32_t)id);
+            counts.emplace_back(rankKey((int)course.prerequisites.size(), course), (uint32_t)id);
+        }
+        
+        byName.build(move(names));
+        byDepartment.build(move(numbers));
+        byPrerequisiteCount.build(move(counts));
+        
+        vector<string> ignored;
+        graph.takeLevelChanges(ignored);
+        rebuildLevels(table, graph);
+        built = true;
+    }
+    
+    /**
+     * Re-index one course after it was added, changed or removed, plus any level changes it caused
+     * @param table Catalog holding the courses
+     * @param graph Graph providing levels
+     * @param courseNumber Course that was edited
+     * Time Complexity: O(log n + n) per touched course for ordered insertion
+     */
+    void refresh(CourseHashTable& table, PrerequisiteGraph& graph, const string& courseNumber) {
+        if (!built) return;
+        
+        // Removed records are dropped by the caller before the table forgets their ID
+        long id = table.recordId(courseNumber);
+        if (id >= 0) {
+            const Course& course = table.getCourse(id);
+            byName.insert((uint32_t)id, nameKey(course));
+            byDepartment.insert((uint32_t)id, numberKey(course));
+            byPrerequisiteCount.insert((uint32_t)id, rankKey((int)course.prerequisites.size(), course));
+            byLevel.insert((uint32_t)id, rankKey(graph.getCourseLevel(course.courseNumber), course));
+        }
+        
+        vector<string> changed;
+        if (!graph.takeLevelChanges(changed)) {
+            rebuildLevels(table, graph);
+            return;
+        }
+        for (const string& number : changed) {
+            long changedId = table.recordId(number);
+            if (changedId < 0) continue;
+            const Course& course = table.getCourse(changedId);
+            byLevel.insert((uint32_t)changedId, rankKey(graph.getCourseLevel(number), course));
+        }
+    }
+    
+    /**
+     * Remove a course from every index
+     * @param id Record ID of the course being removed
+     */
+    void remove(uint32_t id) {
+        byName.erase(id);
+        byDepartment.erase(id);
+        byLevel.erase(id);
+        byPrerequisiteCount.erase(id);
+    }
+    
+    /**
+     * Get the number of indexed courses
+     * @return Course count
+     */
+    size_t size() const {
+        return byName.size();
+    }
+    
+    /**
+     * Get the record ID at a position of an ordering
+     * @param order Ordering to read
+     * @param position Index into the ordering
+     * @return Record ID
+     * Time Complexity: O(1)
+     */
+    uint32_t recordAt(CatalogOrder order, size_t position) const {
+        switch (order) {
+            case CatalogOrder::Name: return byName.at(position);
+            case CatalogOrder::Department: return byDepartment.at(position);
+            case CatalogOrder::Level: return byLevel.at(position);
+            default: return byPrerequisiteCount.at(position);
+        }
+    }
+    
+    /**
+     * Get a whole ordering as a view over the catalog
+     * @param table Catalog the indexes were built from
+     * @param order Ordering to return
+     * @return View over the courses in that order
+     * Time Complexity: O(n), no sorting
+     */
+    CourseOrdering ordering(const CourseHashTable& table, CatalogOrder order) const {
+        vector<uint32_t> ids(size());
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids[i] = recordAt(order, i);
+        }
+        return CourseOrdering(table, move(ids));
+    }
+    
+    /**
+     * Get one page of an ordering by position
+     * @param table Catalog the indexes were built from
+     * @param order Ordering to read
+     * @param offset Position of the first course on the page
+     * @param limit Maximum number of courses on the page
+     * @return View over the courses on the page, empty past the end
+     * Time Complexity: O(limit), no sorting
+     */
+    CourseOrdering page(const CourseHashTable& table, CatalogOrder order, size_t offset, size_t limit) const {
+        size_t begin = min(offset, size());
+        vector<uint32_t> ids(min(limit, size() - begin));
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids[i] = recordAt(order, begin + i);
+        }
+        return CourseOrdering(table, move(ids));
+    }
+    
+    /**
+     * Get the page that follows a cursor, and advance the cursor past it
+     * @param table Catalog the indexes were built from
+     * @param cursor Continuation point; a default cursor starts at the beginning
+     * @param limit Maximum number of courses on the page
+     * @return View over the courses on the page
+     * Time Complexity: O(log n + limit)
+     */
+    CourseOrdering nextPage(const CourseHashTable& table, CatalogCursor& cursor, size_t limit) const {
+        switch (cursor.order) {
+            case CatalogOrder::Name: return pageAfter(table, byName, cursor, limit);
+            case CatalogOrder::Department: return pageAfter(table, byDepartment, cursor, limit);
+            case CatalogOrder::Level: return pageAfter(table, byLevel, cursor, limit);
+            default: return pageAfter(table, byPrerequisiteCount, cursor, limit);
+        }
+    }
+};
+
+
+/**
+ * Shared Catalog Image
+ *
+ * A loaded catalog flattened into one position-independent block of memory, so
+ * that many processes on a host can share a single copy instead of each parsing
+ * the courses file and building its own hash table and graph. One process
+ * publishes the image into a POSIX shared-memory object or a file; the others map
+ * it read-only and query it in place. Every reference inside the image is an
+ * offset from its start, so it works at whatever address each process maps it.
+ *
+ * Layout, after a header of section offsets and counts:
+ * - a string pool holding every course number, name and requirement entry
+ * - one fixed-size entry per course ID: its strings, requirement groups, level
+ *   and descendant count
+ * - an open-addressing hash table from lowercase course number to course ID
+ * - the prerequisite and dependent edges in CSR form, searched with the same
+ *   hybrid BFS as PrerequisiteGraph
+ * - the compiled requirement programs, run by the same evaluator
+ * - the topological order, the criticality ranking and the four catalog orderings
+ *
+ * Course IDs are those of the publishing graph, so a query returns the same
+ * courses in the same order as it would against the loaded catalog. An image is a
+ * snapshot: republishing replaces the name, while processes already attached keep
+ * the snapshot they mapped until they detach. Images are meant for processes of
+ * the same build on the same host. Attaching checks the header, the section
+ * bounds and every reference between sections, so queries can index the image
+ * without further checks.
+ */
+class CatalogImage {
+private:
+    enum Section {
+        STRINGS, // char: string pool
+        ENTRIES, // Entry: one per course ID
+        STRING_LISTS, // StringRef: prerequisite lists and requirement groups
+        GROUPS, // Range: requirement groups, each a range of STRING_LISTS
+        SLOTS, // uint32_t: hash table of course IDs, EMPTY_SLOT when unused
+        PREREQUISITE_OFFSETS, // int: CSR offsets, courseCount + 1 of them
+        PREREQUISITE_TARGETS, // int
+        DEPENDENT_OFFSETS, // int
+        DEPENDENT_TARGETS, // int
+        REQUIREMENT_OFFSETS, // int: program of ID i is REQUIREMENT_OPS[offsets[i] .. offsets[i + 1])
+        REQUIREMENT_OPS, // RequirementOp
+        TOPOLOGICAL_ORDER, // uint32_t: course IDs, prerequisites first
+        CRITICAL_ORDER, // uint32_t: course IDs, most descendants first
+        ORDERINGS, // uint32_t: defined course IDs in each CatalogOrder, one section per order
+        SECTION_COUNT = ORDERINGS + 4
+    };
+    
+    struct StringRef {
+        uint32_t offset; // Position in the string pool
+        uint32_t length; // Length in bytes
+    };
+    
+    struct Range {
+        uint32_t first; // Index of the first element
+        uint32_t count; // Number of elements
+    };
+    
+    struct Entry {
+        static constexpr uint32_t DEFINED = 1; // The catalog has the course, not just references to it
+        
+        StringRef key; // Lowercase course number, empty if the ID was removed
+        StringRef courseNumber; // Course number as written
+        StringRef name; // Full course name
+        Range prerequisites; // Into STRING_LISTS
+        Range prerequisiteGroups; // Into GROUPS
+        Range corequisiteGroups; // Into GROUPS
+        int32_t level; // Minimum number of semesters to complete
+        int32_t descendantCount; // Number of courses that transitively require it
+        uint32_t flags; // DEFINED or 0
+        uint32_t reserved;
+    };
+    
+    struct Header {
+        char magic[8]; // MAGIC, written last when publishing
+        uint32_t version; // VERSION
+        uint32_t courseCount; // Course IDs, including removed and referenced-only ones
+        uint64_t imageSize; // Bytes in the whole image
+        uint64_t offsets[SECTION_COUNT]; // Byte offset of each section from the start of the image
+        uint64_t counts[SECTION_COUNT]; // Number of elements in each section
+    };
+    
+    static constexpr char MAGIC[8] = {'C', 'P', 'L', 'A', 'N', 'I', 'M', 'G'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+    static constexpr size_t ALIGNMENT = 64; // Sections start on cache lines
+    
+    const char* base = nullptr; // Start of the mapped image, null when detached
+    size_t mappedSize = 0; // Length of the mapping
+    const Header* header = nullptr;
+    const Entry* entries = nullptr;
+    const uint32_t* slots = nullptr;
+    size_t slotMask = 0; // Slot count - 1
+    CsrGraphView edges;
+    
+    /**
+     * Get the size of one element of a section
+     */
+    static size_t elementSize(int section) {
+        switch (section) {
+            case STRINGS: return sizeof(char);
+            case ENTRIES: return sizeof(Entry);
+            case STRING_LISTS: return sizeof(StringRef);
+            case GROUPS: return sizeof(Range);
+            case PREREQUISITE_OFFSETS: case PREREQUISITE_TARGETS:
+            case DEPENDENT_OFFSETS: case DEPENDENT_TARGETS: case REQUIREMENT_OFFSETS: return sizeof(int);
+            case REQUIREMENT_OPS: return sizeof(RequirementOp);
+            default: return sizeof(uint32_t);
+        }
+    }
+    
+    /**
+     * Hash a course number without regard to case
+     * FNV-1a, so every process computes the same slots whatever its std::hash
+     */
+    static uint64_t hashKey(const char* text, size_t length) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ (unsigned char)tolower((unsigned char)text[i])) * 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    /**
+     * Check whether a name refers to a POSIX shared-memory object rather than a file
+     * @param name "/name" with no other slash for shared memory, anything else is a path
+     */
+    static bool isSharedMemoryName(const string& name) {
+        return name.size() > 1 && name[0] == '/' && name.find('/', 1) == string::npos;
+    }
+    
+    template <typename T>
+    const T* section(int index) const {
+        return reinterpret_cast<const T*>(base + header->offsets[index]);
+    }
+    
+    string text(const StringRef& ref) const {
+        return string(section<char>(STRINGS) + ref.offset, ref.length);
+    }
+    
+    vector<string> textList(const Range& range) const {
+        vector<string> list;
+        list.reserve(range.count);
+        for (uint32_t i = 0; i < range.count; i++) {
+            list.push_back(text(section<StringRef>(STRING_LISTS)[range.first + i]));
+        }
+        return list;
+    }
+    
+    vector<vector<string>> textGroups(const Range& range) const {
+        vector<vector<string>> groups;
+        groups.reserve(range.count);
+        for (uint32_t i = 0; i < range.count; i++) {
+            groups.push_back(textList(section<Range>(GROUPS)[range.first + i]));
+        }
+        return groups;
+    }
+    
+    /**
+     * Check a mapped header and cache pointers to the sections queries use
+     * @return false, with a reason in error, if the image is not usable
+     */
+    bool validate(string& error) {
+        header = reinterpret_cast<const Header*>(base);
+        if (mappedSize < sizeof(Header) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+            error = "not a catalog image, or still being published";
+            return false;
+        }
+        if (header->version != VERSION || header->imageSize > mappedSize) {
+            error = "incompatible or truncated catalog image";
+            return false;
+        }
+        
+        size_t n = header->courseCount;
+        for (int i = 0; i < SECTION_COUNT; i++) {
+            uint64_t offset = header->offsets[i], count = header->counts[i];
+            if (offset % ALIGNMENT != 0 || offset > header->imageSize ||
+                count > (header->imageSize - offset) / elementSize(i)) {
+                error = "corrupt catalog image section";
+                return false;
+            }
+        }
+        uint64_t slotCount = header->counts[SLOTS];
+        if (header->counts[ENTRIES] != n || slotCount == 0 || (slotCount & (slotCount - 1)) != 0 ||
+            header->counts[PREREQUISITE_OFFSETS] != n + 1 || header->counts[DEPENDENT_OFFSETS] != n + 1 ||
+            header->counts[REQUIREMENT_OFFSETS] != n + 1) {
+            error = "corrupt catalog image section";
+            return false;
+        }
+        
+        entries = section<Entry>(ENTRIES);
+        if (!referencesValid()) {
+            error = "corrupt catalog image reference";
+            return false;
+        }
+        slots = section<uint32_t>(SLOTS);
+        slotMask = slotCount - 1;
+        edges = {section<int>(PREREQUISITE_OFFSETS), section<int>(PREREQUISITE_TARGETS),
+                 section<int>(DEPENDENT_OFFSETS), section<int>(DEPENDENT_TARGETS), n};
+        return true;
+    }
+    
+    /**
+     * Check every reference inside a mapped image against the section it points into
+     *
+     * String refs must lie in the string pool, ranges in the section they index,
+     * CSR and requirement offsets must ascend from 0 to the length of their
+     * targets, and every stored course ID must be below the course count. The hash
+     * table needs an empty slot so lookups of unknown courses stop.
+     *
+     * @return false if any reference is out of bounds
+     * Time Complexity: O(image size)
+     */
+    bool referencesValid() const {
+        const uint64_t* counts = header->counts;
+        size_t n = header->courseCount;
+        auto stringValid = [&](const StringRef& ref) {
+            return (uint64_t)ref.offset + ref.length <= counts[STRINGS];
+        };
+        auto rangeValid = [&](const Range& range, int target) {
+            return (uint64_t)range.first + range.count <= counts[target];
+        };
+        auto idsValid = [&](int index) {
+            const uint32_t* ids = section<uint32_t>(index);
+            return all_of(ids, ids + counts[index], [&](uint32_t id) { return id < n; });
+        };
+        auto offsetsValid = [&](int index, uint64_t targetCount) {
+            const int* offsets = section<int>(index);
+            if (offsets[0] != 0 || (uint64_t)offsets[n] != targetCount) return false;
+            for (size_t id = 0; id < n; id++) {
+                if (offsets[id + 1] < offsets[id]) return false;
+            }
+            return true;
+        };
+        
+        for (size_t id = 0; id < n; id++) {
+            const Entry& entry = entries[id];
+            if (!stringValid(entry.key) || !stringValid(entry.courseNumber) || !stringValid(entry.name) ||
+                !rangeValid(entry.prerequisites, STRING_LISTS) || !rangeValid(entry.prerequisiteGroups, GROUPS) ||
+                !rangeValid(entry.corequisiteGroups, GROUPS)) {
+                return false;
+            }
+        }
+        const StringRef* lists = section<StringRef>(STRING_LISTS);
+        if (!all_of(lists, lists + counts[STRING_LISTS], stringValid)) return false;
+        const Range* groups = section<Range>(GROUPS);
+        for (uint64_t i = 0; i < counts[GROUPS]; i++) {
+            if (!rangeValid(groups[i], STRING_LISTS)) return false;
+        }
+        
+        const uint32_t* slotList = section<uint32_t>(SLOTS);
+        bool hasEmptySlot = false;
+        for (uint64_t i = 0; i < counts[SLOTS]; i++) {
+            if (slotList[i] == EMPTY_SLOT) hasEmptySlot = true;
+            else if (slotList[i] >= n) return false;
+        }
+        if (!hasEmptySlot) return false;
+        
+        for (int index : {PREREQUISITE_TARGETS, DEPENDENT_TARGETS}) {
+            const int* targets = section<int>(index);
+            if (!all_of(targets, targets + counts[index], [&](int id) { return id >= 0 && (size_t)id < n; })) return false;
+        }
+        if (!offsetsValid(PREREQUISITE_OFFSETS, counts[PREREQUISITE_TARGETS]) ||
+            !offsetsValid(DEPENDENT_OFFSETS, counts[DEPENDENT_TARGETS]) ||
+            !offsetsValid(REQUIREMENT_OFFSETS, counts[REQUIREMENT_OPS])) {
+            return false;
+        }
+        
+        for (int index = TOPOLOGICAL_ORDER; index < SECTION_COUNT; index++) {
+            if (!idsValid(index)) return false;
+        }
+        return true;
+    }
+    
+    /**
+     * Write an image under a name, making it visible to attach only once complete
+     *
+     * Files are written beside the target and renamed over it. Shared-memory
+     * objects cannot be renamed, so the old object is unlinked and the new one is
+     * filled body first and header last; an attach that races with publishing
+     * sees no magic and fails rather than reading a partial image.
+     *
+     * @return false, with a reason in error, if the image could not be written
+     */
+    static bool writeImage(const string& name, const string& image, string& error) {
+        bool shared = isSharedMemoryName(name);
+        string target = shared ? name : name + ".tmp";
+        int fd;
+        if (shared) {
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        } else {
+            fd = open(target.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+        }
+        if (fd < 0) {
+            error = strerror(errno);
+            return false;
+        }
+        
+        // Body first, then the header that makes it valid
+        bool ok = ftruncate(fd, (off_t)image.size()) == 0;
+        for (size_t part = 0; part < 2 && ok; part++) {
+            size_t begin = (part == 0) ? sizeof(Header) : 0;
+            size_t end = (part == 0) ? image.size() : sizeof(Header);
+            while (begin < end) {
+                ssize_t written = pwrite(fd, image.data() + begin, end - begin, (off_t)begin);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) {
+                    ok = false;
+                    break;
+                }
+                begin += (size_t)written;
+            }
+        }
+        if (!ok) error = strerror(errno);
+        close(fd);
+        
+        if (ok && !shared && rename(target.c_str(), name.c_str()) != 0) {
+            error = strerror(errno);
+            ok = false;
+        }
+        if (!ok) {
+            if (shared) shm_unlink(name.c_str());
+            else unlink(target.c_str());
+        }
+        return ok;
+    }
+    
+public:
+    CatalogImage() {}
+    CatalogImage(const CatalogImage&) = delete;
+    CatalogImage& operator=(const CatalogImage&) = delete;
+    
+    ~CatalogImage() {
+        detach();
+    }
+    
+    /**
+     * Flatten a loaded catalog into an image and publish it under a name
+     *
+     * @param name "/name" for a POSIX shared-memory object, otherwise a file path
+     * @param table Loaded courses
+     * @param graph Prerequisite graph of the same courses
+     * @param indexes Built catalog indexes of the same courses
+     * @param bytes Output: size of the published image
+     * @param error Output: reason for failure
+     * @return false if the image could not be written
+     * Time Complexity: O(V + E + total string length), plus any graph caches still to compute
+     */
+    static bool publish(const string& name, CourseHashTable& table, PrerequisiteGraph& graph,
+                        const CatalogIndexes& indexes, size_t& bytes, string& error) {
+        if (!graph.levelsValid) graph.computeLevels();
+        if (!graph.descendantCountsValid) graph.computeDescendantCounts();
+        if (!graph.requirementsValid) graph.compileRequirements();
+        graph.ensureCsr();
+        
+        size_t n = graph.courseKeys.size();
+        // Course numbers recur across requirement lists and are stored once; names are not shared
+        string strings;
+        unordered_map<string, StringRef> pooled;
+        auto appendString = [&](const string& value) {
+            StringRef ref = {(uint32_t)strings.size(), (uint32_t)value.size()};
+            strings += value;
+            return ref;
+        };
+        auto addString = [&](const string& value) {
+            auto it = pooled.find(value);
+            if (it != pooled.end()) return it->second;
+            return pooled.emplace(value, appendString(value)).first->second;
+        };
+        vector<StringRef> stringLists;
+        auto addList = [&](const vector<string>& values) {
+            Range range = {(uint32_t)stringLists.size(), (uint32_t)values.size()};
+            for (const string& value : values) stringLists.push_back(addString(value));
+            return range;
+        };
+        vector<Range> groups;
+        auto addGroups = [&](const vector<vector<string>>& values) {
+            Range range = {(uint32_t)groups.size(), (uint32_t)values.size()};
+            for (const vector<string>& group : values) groups.push_back(addList(group));
+            return range;
+        };
+        
+        vector<Entry> entryList(n);
+        vector<uint32_t> recordIds(table.recordCount(), EMPTY_SLOT); // Hash table record ID -> course ID
+        size_t keyed = 0;
+        for (size_t id = 0; id < n; id++) {
+            Entry& entry = entryList[id];
+            memset(&entry, 0, sizeof(entry));
+            const string& key = graph.courseKeys[id];
+            if (key.empty()) continue;
+            keyed++;
+            entry.key = addString(key);
+            entry.level = graph.courseLevels[id];
+            entry.descendantCount = graph.descendantCounts[id];
+            
+            long record = table.recordId(key);
+            if (record >= 0) {
+                const Course& course = table.getCourse(record);
+                recordIds[record] = (uint32_t)id;
+                entry.flags = Entry::DEFINED;
+                entry.courseNumber = addString(course.courseNumber);
+                entry.name = appendString(course.name);
+                entry.prerequisites = addList(course.prerequisites);
+                entry.prerequisiteGroups = addGroups(course.prerequisiteGroups);
+                entry.corequisiteGroups = addGroups(course.corequisiteGroups);
+            }
+        }
+        if (strings.size() > UINT32_MAX || stringLists.size() > UINT32_MAX) {
+            error = "catalog too large for an image";
+            return false;
+        }
+        
+        size_t slotCount = 16;
+        while (slotCount < 2 * keyed) slotCount *= 2;
+        vector<uint32_t> slotList(slotCount, EMPTY_SLOT);
+        for (size_t id = 0; id < n; id++) {
+            const string& key = graph.courseKeys[id];
+            if (key.empty()) continue;
+            size_t slot = hashKey(key.data(), key.size()) & (slotCount - 1);
+            while (slotList[slot] != EMPTY_SLOT) slot = (slot + 1) & (slotCount - 1);
+            slotList[slot] = (uint32_t)id;
+        }
+        
+        vector<uint32_t> topological;
+        for (int id : graph.topologicalOrder) {
+            if (!graph.courseKeys[id].empty()) topological.push_back((uint32_t)id);
+        }
+        vector<uint32_t> critical;
+        for (const pair<string, int>& ranked : graph.rankByCriticality()) {
+            critical.push_back((uint32_t)graph.getCourseId(ranked.first));
+        }
+        vector<uint32_t> orderings[4];
+        const CatalogOrder orders[4] = {CatalogOrder::Name, CatalogOrder::Department, CatalogOrder::Level, CatalogOrder::PrerequisiteCount};
+        for (int i = 0; i < 4; i++) {
+            for (size_t position = 0; position < indexes.size(); position++) {
+                orderings[i].push_back(recordIds[indexes.recordAt(orders[i], position)]);
+            }
+        }
+        
+        Header head;
+        memset(&head, 0, sizeof(head));
+        head.version = VERSION;
+        head.courseCount = (uint32_t)n;
+        string image((sizeof(Header) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, '\0');
+        auto addSection = [&](int index, const void* data, size_t count) {
+            image.resize((image.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, '\0');
+            head.offsets[index] = image.size();
+            head.counts[index] = count;
+            image.append(static_cast<const char*>(data), count * elementSize(index));
+        };
+        addSection(STRINGS, strings.data(), strings.size());
+        addSection(ENTRIES, entryList.data(), entryList.size());
+        addSection(STRING_LISTS, stringLists.data(), stringLists.size());
+        addSection(GROUPS, groups.data(), groups.size());
+        addSection(SLOTS, slotList.data(), slotList.size());
+        addSection(PREREQUISITE_OFFSETS, graph.prerequisiteOffsets.data(), graph.prerequisiteOffsets.size());
+        addSection(PREREQUISITE_TARGETS, graph.prerequisiteTargets.data(), graph.prerequisiteTargets.size());
+        addSection(DEPENDENT_OFFSETS, graph.dependentOffsets.data(), graph.dependentOffsets.size());
+        addSection(DEPENDENT_TARGETS, graph.dependentTargets.data(), graph.dependentTargets.size());
+        addSection(REQUIREMENT_OFFSETS, graph.requirementOffsets.data(), graph.requirementOffsets.size());
+        addSection(REQUIREMENT_OPS, graph.requirementOps.data(), graph.requirementOps.size());
+        addSection(TOPOLOGICAL_ORDER, topological.data(), topological.size());
+        addSection(CRITICAL_ORDER, critical.data(), critical.size());
+        for (int i = 0; i < 4; i++) {
+            addSection(ORDERINGS + (int)orders[i], orderings[i].data(), orderings[i].size());
+        }
+        head.imageSize = image.size();
+        memcpy(head.magic, MAGIC, sizeof(MAGIC));
+        memcpy(&image[0], &head, sizeof(head));
+        
+        bytes = image.size();
+        return writeImage(name, image, error);
+    }
+    
+    /**
+     * Remove a published image; processes attached to it keep their mapping
+     * @param name Name it was published under
+     * @return false if there was nothing to remove
+     */
+    static bool unpublish(const string& name) {
+        return (isSharedMemoryName(name) ? shm_unlink(name.c_str()) : unlink(name.c_str())) == 0;
+    }
+    
+    /**
+     * Map a published image read-only, replacing any image already attached
+     * @param name Name it was published under
+     * @param error Output: reason for failure
+     * @return false if the image is missing or unusable
+     * Time Complexity: O(image size) to check its references
+     */
+    bool attach(const string& name, string& error) {
+        detach();
+        int fd = isSharedMemoryName(name) ? shm_open(name.c_str(), O_RDONLY, 0) : open(name.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            error = strerror(errno);
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        
+        void* mapped = (info.st_size > 0) ? mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (mapped == MAP_FAILED) {
+            error = (info.st_size > 0) ? strerror(errno) : "empty catalog image";
+            close(fd);
+            return false;
+        }
+        close(fd);
+        
+        base = static_cast<const char*>(mapped);
+        mappedSize = (size_t)info.st_size;
+        if (!validate(error)) {
+            detach();
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * Unmap the attached image, if any
+     */
+    void detach() {
+        if (base) munmap(const_cast<char*>(base), mappedSize);
+        base = nullptr;
+        mappedSize = 0;
+        header = nullptr;
+    }
+    
+    bool isAttached() const {
+        return base != nullptr;
+    }
+    
+    /**
+     * Get the size of the attached image in bytes
+     */
+    size_t byteSize() const {
+        return header ? header->imageSize : 0;
+    }
+    
+    /**
+     * Get the number of course IDs, including removed and referenced-only ones
+     */
+    size_t courseCount() const {
+        return header ? header->courseCount : 0;
+    }
+    
+    /**
+     * Get the number of courses in the catalog
+     */
+    size_t size() const {
+        return header ? header->counts[ORDERINGS] : 0;
+    }
+    
+    /**
+     * Look up the ID of a course, ignoring case
+     * @param courseNumber Course to find
+     * @return Course ID, or -1 if the course is unknown
+     * Time Complexity: O(1) average case
+     */
+    int find(const string& courseNumber) const {
+        const char* strings = section<char>(STRINGS);
+        for (size_t slot = hashKey(courseNumber.data(), courseNumber.size()) & slotMask;
+             slots[slot] != EMPTY_SLOT; slot = (slot + 1) & slotMask) {
+            const StringRef& key = entries[slots[slot]].key;
+            if (key.length != courseNumber.size()) continue;
+            
+            size_t i = 0;
+            while (i < key.length && strings[key.offset + i] == (char)tolower((unsigned char)courseNumber[i])) i++;
+            if (i == key.length) return (int)slots[slot];
+        }
+        return -1;
+    }
+    
+    /**
+     * Check whether the catalog has a course, rather than only references to it
+     */
+    bool isDefined(int id) const {
+        return entries[id].flags & Entry::DEFINED;
+    }
+    
+    /**
+     * Copy a course out of the image
+     * @param id ID of a defined course
+     */
+    Course course(int id) const {
+        const Entry& entry = entries[id];
+        Course course;
+        course.courseNumber = text(entry.courseNumber);
+        course.name = text(entry.name);
+        course.prerequisites = textList(entry.prerequisites);
+        course.prerequisiteGroups = textGroups(entry.prerequisiteGroups);
+        course.corequisiteGroups = textGroups(entry.corequisiteGroups);
+        return course;
+    }
+    
+    /**
+     * Get a course's number as written, or its lowercase key if it is only referenced
+     */
+    string courseNumber(int id) const {
+        return text(isDefined(id) ? entries[id].courseNumber : entries[id].key);
+    }
+    
+    /**
+     * Get a course's name, empty if it is only referenced
+     */
+    string name(int id) const {
+        return text(entries[id].name);
+    }
+    
+    int level(int id) const {
+        return entries[id].level;
+    }
+    
+    int descendantCount(int id) const {
+        return entries[id].descendantCount;
+    }
+    
+    /**
+     * Get one of the catalog orderings
+     * @return IDs of every course in that order
+     */
+    span<const uint32_t> ordering(CatalogOrder order) const {
+        int index = ORDERINGS + (int)order;
+        return span<const uint32_t>(section<uint32_t>(index), header->counts[index]);
+    }
+    
+    /**
+     * Get every course ID in topological order; courses on a cycle are omitted
+     */
+    span<const uint32_t> topologicalOrder() const {
+        return span<const uint32_t>(section<uint32_t>(TOPOLOGICAL_ORDER), header->counts[TOPOLOGICAL_ORDER]);
+    }
+    
+    /**
+     * Get every course ID ranked by descendant count, most critical first, ties by course number
+     */
+    span<const uint32_t> criticalOrder() const {
+        return span<const uint32_t>(section<uint32_t>(CRITICAL_ORDER), header->counts[CRITICAL_ORDER]);
+    }
+    
+    /**
+     * Build a bitset over the image's course IDs from a list of course numbers
+     * @param courseNumbers Courses to include; unknown course numbers are ignored
+     */
+    CourseBitset makeCourseSet(const vector<string>& courseNumbers) const {
+        CourseBitset set(courseCount());
+        for (const string& courseNumber : courseNumbers) {
+            int id = find(courseNumber);
+            if (id >= 0) set.set(id);
+        }
+        return set;
+    }
+    
+    /**
+     * Check if a student may take a course they have not completed
+     * @param id Course ID
+     * @param completed Courses the student has completed
+     * @param enrolled Courses the student is taking this semester, may be null
+     * @return true if the course is defined, not completed and its requirements are satisfied
+     */
+    bool isEligible(int id, const CourseBitset& completed, const CourseBitset* enrolled) const {
+        RequirementProgramView programs = requirementPrograms();
+        return isDefined(id) && !completed.test(id) &&
+               PrerequisiteGraph::evaluateProgram(programs.ops + programs.offsets[id], programs.ops + programs.offsets[id + 1],
+                                                  completed, enrolled);
+    }
+    
+    /**
+     * Get the compiled requirement programs of every course
+     * @return View valid while the image stays attached
+     */
+    RequirementProgramView requirementPrograms() const {
+        return {section<RequirementOp>(REQUIREMENT_OPS), section<int>(REQUIREMENT_OFFSETS), courseCount()};
+    }
+    
+    /**
+     * Start a k-hop search over the image's edges
+     * @param id Course ID to start from
+     * @param direction Whether to walk towards dependents or prerequisites
+     * @param maxHops Maximum number of hops, negative for unlimited
+     * @return Search reporting through resultIds(); valid while the image stays attached
+     */
+    PrerequisiteGraph::HopSearch startHopSearch(int id, TraversalDirection direction, int maxHops = -1) const {
+        return PrerequisiteGraph::startHopSearch(edges, id, direction, maxHops);
+    }
+};
+
+
+/**
+ * Transcript Store
+ *
+ * Every course attempt of every student as (student, course, term, grade,
+ * credits) rows, kept column by column. Student, course and term names are
+ * dictionary-encoded, so a row costs 8 bytes however long its names are: a
+ * 32-bit course, a 16-bit term and one byte each of grade and credits. Rows are
+ * streamed in from CSV, then grouped by student and ordered by term with two
+ * counting sorts, so one student's history is a contiguous run of every column.
+ *
+ * Grades are letter grades (stored as tenths of grade points, A = 40), pass
+ * grades P, S and CR, and non-credit grades W, I, IP, NP, NC and U. D- and
+ * above, and pass grades, pass a course.
+ */
+class TranscriptStore {
+public:
+    static constexpr uint8_t PASS = 254; // Passed a pass/fail course
+    static constexpr uint8_t NO_CREDIT = 255; // Withdrawn, incomplete, in progress or not passed
+    static constexpr uint8_t DEFAULT_CREDITS = 3; // Credits of a row that gives none
+    
+private:
+    static constexpr uint8_t LOWEST_PASSING = 7; // D-
+    
+    vector<string> studentNames; // Student -> name as written
+    unordered_map<string, uint32_t> studentIds; // Name -> student
+    vector<string> courseNumbers; // Course -> course number as first written
+    unordered_map<string, uint32_t> courseIds; // Lowercase course number -> course
+    vector<string> termNames; // Term -> name; after grouping, terms are numbered in sorted order
+    unordered_map<string, uint32_t> termIds; // Name -> term, only while reading
+    
+    vector<uint32_t> studentColumn; // Row -> student, only while reading
+    vector<uint32_t> courseColumn; // Row -> course
+    vector<uint16_t> termColumn; // Row -> term
+    vector<uint8_t> gradeColumn; // Row -> grade
+    vector<uint8_t> creditColumn; // Row -> credits
+    vector<uint32_t> studentOffsets; // Rows of student s are [offsets[s], offsets[s + 1])
+    
+    /**
+     * Look up a dictionary entry, adding it if it is new
+     * @param dictionary Name -> code
+     * @param names Code -> name
+     * @param key Lookup key
+     * @param name Name stored for a new entry
+     * @return Code of the entry
+     */
+    static uint32_t encode(unordered_map<string, uint32_t>& dictionary, vector<string>& names,
+                           const string& key, const string& name) {
+        auto it = dictionary.find(key);
+        if (it != dictionary.end()) return it->second;
+        names.push_back(name);
+        return dictionary.emplace(key, (uint32_t)(names.size() - 1)).first->second;
+    }
+    
+    /**
+     * Split a CSV line into fields, honouring double quotes
+     * @param line Line to split
+     * @param fields Output: fields, reusing their storage
+     * @return Number of fields, which may exceed fields.size() (extra fields are dropped)
+     */
+    template <size_t N>
+    static size_t splitCsv(const string& line, array<string, N>& fields) {
+        size_t count = 0;
+        size_t i = 0;
+        while (true) {
+            string scratch;
+            string& field = (count < N) ? fields[count] : scratch;
+            field.clear();
+            
+            if (i < line.size() && line[i] == '"') {
+                // Quoted: "" is a literal quote, and anything after the closing quote is kept
+                for (i++; i < line.size(); i++) {
+                    if (line[i] != '"') {
+                        field += line[i];
+                    } else if (i + 1 < line.size() && line[i + 1] == '"') {
+                        field += line[++i];
+                    } else {
+                        i++;
+                        break;
+                    }
+                }
+            }
+            // Unquoted fields, the common case, are copied whole
+            size_t end = min(line.find(',', i), line.size());
+            field.append(line, i, end - i);
+            if (end == line.size() && !field.empty() && field.back() == '\r') field.pop_back();
+            i = end;
+            count++;
+            if (i >= line.size() || line[i] != ',') return count;
+            i++;
+        }
+    }
+    
+    /**
+     * Group the rows read so far by student, ordered by term within each student
+     *
+     * Terms are renumbered in sorted order first, then rows are counting-sorted by
+     * term and stably counting-sorted again by student.
+     */
+    void groupRows() {
+        vector<uint32_t> termOrder(termNames.size());
+        for (uint32_t t = 0; t < termOrder.size(); t++) termOrder[t] = t;
+        sort(termOrder.begin(), termOrder.end(), [&](uint32_t a, uint32_t b) { return termNames[a] < termNames[b]; });
+        vector<uint16_t> termRank(termNames.size());
+        vector<string> sortedTerms(termNames.size());
+        for (size_t rank = 0; rank < termOrder.size(); rank++) {
+            termRank[termOrder[rank]] = (uint16_t)rank;
+            sortedTerms[rank] = move(termNames[termOrder[rank]]);
+        }
+        termNames = move(sortedTerms);
+        termIds.clear();
+        for (uint16_t& term : termColumn) term = termRank[term];
+        
+        size_t rows = courseColumn.size();
+        auto countingSort = [rows](const vector<uint32_t>& order, size_t keyCount, auto key) {
+            vector<uint32_t> offsets(keyCount + 1, 0);
+            for (size_t row = 0; row < rows; row++) offsets[key(row) + 1]++;
+            for (size_t k = 0; k < keyCount; k++) offsets[k + 1] += offsets[k];
+            vector<uint32_t> sorted(rows);
+            for (uint32_t row : order) sorted[offsets[key(row)]++] = row;
+            return sorted;
+        };
+        vector<uint32_t> order(rows);
+        for (uint32_t row = 0; row < rows; row++) order[row] = row;
+        order = countingSort(order, termNames.size(), [&](size_t row) { return termColumn[row]; });
+        order = countingSort(order, studentNames.size(), [&](size_t row) { return studentColumn[row]; });
+        
+        studentOffsets.assign(studentNames.size() + 1, 0);
+        for (uint32_t student : studentColumn) studentOffsets[student + 1]++;
+        for (size_t s = 0; s < studentNames.size(); s++) studentOffsets[s + 1] += studentOffsets[s];
+        
+        auto permute = [&](auto& column) {
+            typename remove_reference<decltype(column)>::type sorted(rows);
+            for (size_t i = 0; i < rows; i++) sorted[i] = column[order[i]];
+            column = move(sorted);
+        };
+        permute(courseColumn);
+        permute(termColumn);
+        permute(gradeColumn);
+        permute(creditColumn);
+        studentColumn = vector<uint32_t>();
+    }
+    
+public:
+    /**
+     * Parse a grade
+     * @param text Grade as written, any case
+     * @param grade Set to tenths of grade points, PASS or NO_CREDIT
+     * @return false if the grade is not recognised
+     */
+    static bool parseGrade(const string& text, uint8_t& grade) {
+        static const pair<const char*, uint8_t> GRADES[] = {
+            {"A+", 40}, {"A", 40}, {"A-", 37}, {"B+", 33}, {"B", 30}, {"B-", 27}, {"C+", 23}, {"C", 20},
+            {"C-", 17}, {"D+", 13}, {"D", 10}, {"D-", 7}, {"F", 0}, {"WF", 0}, {"P", PASS}, {"S", PASS},
+            {"CR", PASS}, {"W", NO_CREDIT}, {"I", NO_CREDIT}, {"IP", NO_CREDIT}, {"NP", NO_CREDIT},
+            {"NC", NO_CREDIT}, {"U", NO_CREDIT}
+        };
+        for (const auto& known : GRADES) {
+            if (text.size() == strlen(known.first) &&
+                equal(text.begin(), text.end(), known.first, [](char a, char b) { return toupper((unsigned char)a) == b; })) {
+                grade = known.second;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * Check whether a grade passes a course
+     */
+    static bool isPassing(uint8_t grade) {
+        return grade == PASS || (grade >= LOWEST_PASSING && grade != NO_CREDIT);
+    }
+    
+    /**
+     * Replace the store's contents with rows streamed from CSV
+     *
+     * Each line is student,course,term,grade[,credits]; credits default to
+     * DEFAULT_CREDITS. A first non-blank line starting with "student" is taken as a header.
+     * Terms are ordered by comparing their names, so they should be written in a
+     * sortable form such as 2024-1. The whole input is rejected if a line is malformed.
+     *
+     * @param in Stream of CSV rows
+     * @param error Output: the first malformed line and why
+     * @return false if a line was malformed, leaving the store empty
+     * Time Complexity: O(rows + students + terms log terms)
+     */
+    bool read(istream& in, string& error) {
+        *this = TranscriptStore();
+        array<string, 5> fields;
+        string line, key;
+        size_t lineNumber = 0;
+        uint32_t student = 0, term = 0;
+        bool firstRow = true;
+        
+        while (getline(in, line)) {
+            lineNumber++;
+            if (line.empty() || line == "\r") continue;
+            size_t count = splitCsv(line, fields);
+            bool header = firstRow && lowercase(fields[0]) == "student";
+            firstRow = false;
+            if (header) continue;
+            
+            uint8_t grade = 0;
+            unsigned credits = DEFAULT_CREDITS;
+            const char* problem = nullptr;
+            if (count < 4 || count > 5) problem = "expected student,course,term,grade[,credits]";
+            else if (fields[0].empty() || fields[1].empty() || fields[2].empty()) problem = "empty student, course or term";
+            else if (!parseGrade(fields[3], grade)) problem = "unknown grade";
+            else if (count == 5 && (from_chars(fields[4].data(), fields[4].data() + fields[4].size(), credits).ec != errc() ||
+                                    credits > UINT8_MAX)) problem = "credits must be a number up to 255";
+            if (problem) {
+                error = "line " + to_string(lineNumber) + ": " + problem;
+                *this = TranscriptStore();
+                return false;
+            }
+            
+            // A student's rows usually arrive together, so repeat lookups are skipped
+            if (studentColumn.empty() || fields[0] != studentNames[student]) {
+                student = encode(studentIds, studentNames, fields[0], fields[0]);
+            }
+            if (termColumn.empty() || fields[2] != termNames[term]) {
+                term = encode(termIds, termNames, fields[2], fields[2]);
+            }
+            studentColumn.push_back(student);
+            key.assign(fields[1]);
+            transform(key.begin(), key.end(), key.begin(), ::tolower);
+            courseColumn.push_back(encode(courseIds, courseNumbers, key, fields[1]));
+            if (term > UINT16_MAX) {
+                error = "line " + to_string(lineNumber) + ": more than 65536 terms";
+                *this = TranscriptStore();
+                return false;
+            }
+            termColumn.push_back((uint16_t)term);
+            gradeColumn.push_back(grade);
+            creditColumn.push_back((uint8_t)credits);
+        }
+        
+        groupRows();
+        return true;
+    }
+    
+    size_t rowCount() const {
+        return courseColumn.size();
+    }
+    
+    size_t studentCount() const {
+        return studentNames.size();
+    }
+    
+    size_t courseCount() const {
+        return courseNumbers.size();
+    }
+    
+    /**
+     * Get the memory held by the columns and offsets, excluding the dictionaries
+     */
+    size_t columnBytes() const {
+        return courseColumn.size() * sizeof(uint32_t) + termColumn.size() * sizeof(uint16_t) +
+               gradeColumn.size() + creditColumn.size() + studentOffsets.size() * sizeof(uint32_t);
+    }
+    
+    const string& studentName(size_t student) const {
+        return studentNames[student];
+    }
+    
+    const string& courseNumber(size_t course) const {
+        return courseNumbers[course];
+    }
+    
+    const string& termName(size_t term) const {
+        return termNames[term];
+    }
+    
+    /**
+     * Look up a student by name
+     * @return Student index, or -1 if the student has no rows
+     */
+    long findStudent(const string& name) const {
+        auto it = studentIds.find(name);
+        return (it != studentIds.end()) ? (long)it->second : -1;
+    }
+    
+    /**
+     * Look up a course by number, ignoring case
+     * @return Course index, or -1 if no row mentions the course
+     */
+    long findCourse(const string& courseNumber) const {
+        auto it = courseIds.find(lowercase(courseNumber));
+        return (it != courseIds.end()) ? (long)it->second : -1;
+    }
+    
+    /**
+     * Get the first row of a student; their rows run to firstRow(student + 1)
+     */
+    size_t firstRow(size_t student) const {
+        return studentOffsets[student];
+    }
+    
+    uint32_t course(size_t row) const {
+        return courseColumn[row];
+    }
+    
+    uint16_t term(size_t row) const {
+        return termColumn[row];
+    }
+    
+    uint8_t grade(size_t row) const {
+        return gradeColumn[row];
+    }
+    
+    uint8_t credits(size_t row) const {
+        return creditColumn[row];
+    }
+    
+    /**
+     * Lowercase a course number for dictionary lookups
+     */
+    static string lowercase(string text) {
+        transform(text.begin(), text.end(), text.begin(), ::tolower);
+        return text;
+    }
+};
+
+
+/**
+ * Degree Requirement Rule
+ */
+struct AuditRule
+{
+    enum class Kind {
+        Courses, // At least required of courses passed
+        Credits, // At least required credits from passed courses matching a prefix in courses (any course if none)
+        Prerequisites // Every course taken only once its prerequisites were passed
+    };
+    
+    string name; // Label reported when the rule is not met
+    Kind kind = Kind::Courses;
+    int required = 0; // Courses or credits needed
+    vector<string> courses; // Course numbers, or course number prefixes for Credits
+};
+
+
+/**
+ * Degree Audit Engine
+ *
+ * Checks every student of a TranscriptStore against a list of degree
+ * requirement rules. The rules are compiled once against the store's course
+ * dictionary: each course gets the list of course and credit rules it counts
+ * towards, so auditing a student is one pass over their rows, counting each
+ * passed course once however often it was retaken. Prerequisite rules replay
+ * the rows term by term against the catalog's compiled requirement programs:
+ * courses passed in earlier terms are completed, and courses taken in the same
+ * term count as enrollment for co-requisites.
+ *
+ * audit() only reads the engine, so students can be audited on many threads at
+ * once, each with its own Scratch.
+ */
+class DegreeAudit {
+private:
+    const TranscriptStore& store;
+    vector<AuditRule> rules;
+    RequirementProgramView programs; // Catalog requirement programs
+    vector<int> catalogIds; // Store course -> catalog course ID, -1 if the catalog does not have it
+    vector<uint32_t> memberOffsets; // Rules counted by store course c are memberRules[offsets[c] .. offsets[c + 1])
+    vector<uint32_t> memberRules;
+    bool checksPrerequisites = false; // Whether any rule is a Prerequisites rule
+    
+public:
+    /**
+     * Per-thread working memory for audit()
+     */
+    struct Scratch {
+        vector<uint32_t> countedIn; // Store course -> generation of the audit that last counted it
+        uint32_t generation = 0; // Number of audits run with this scratch
+        vector<int> progress; // Rule -> courses or credits so far
+        CourseBitset completed; // Catalog courses passed in earlier terms
+        CourseBitset enrolled; // Catalog courses taken in the current term
+        vector<int> passed; // Catalog IDs set in completed, to clear afterwards
+        
+        explicit Scratch(const DegreeAudit& audit)
+            : countedIn(audit.store.courseCount(), 0), progress(audit.rules.size(), 0),
+              completed(audit.programs.courseCount), enrolled(audit.programs.courseCount) {}
+    };
+    
+    /**
+     * Parse degree requirement rules, one per line:
+     * - name: N of <course>... - at least N of the courses passed
+     * - name: all <course>... - every course passed
+     * - name: credits N [prefix]... - at least N credits from passed courses whose
+     *   number starts with one of the prefixes, or from any course
+     * - name: prerequisites - every course taken only after its prerequisites were passed
+     * Blank lines and lines starting with '#' are ignored. A course listed twice in
+     * one rule counts once, so "all A A" needs only A.
+     *
+     * @param in Stream of rules
+     * @param rules Output: parsed rules
+     * @param error Output: the first malformed line and why
+     * @return false if a line was malformed
+     */
+    static bool parseRules(istream& in, vector<AuditRule>& rules, string& error) {
+        auto parseNumber = [](const string& text, int& value) {
+            auto result = from_chars(text.data(), text.data() + text.size(), value);
+            return result.ec == errc() && result.ptr == text.data() + text.size() && value >= 0;
+        };
+        auto distinctCourses = [](vector<string>::const_iterator first, vector<string>::const_iterator last) {
+            vector<string> courses;
+            unordered_set<string> seen;
+            for (; first != last; ++first) {
+                if (seen.insert(TranscriptStore::lowercase(*first)).second) courses.push_back(*first);
+            }
+            return courses;
+        };
+        
+        string line;
+        size_t lineNumber = 0;
+        while (getline(in, line)) {
+            lineNumber++;
+            size_t start = line.find_first_not_of(" \t\r");
+            if (start == string::npos || line[start] == '#') continue;
+            
+            size_t colon = line.find(':');
+            AuditRule rule;
+            vector<string> args;
+            if (colon != string::npos) {
+                rule.name = line.substr(start, colon - start);
+                rule.name.erase(rule.name.find_last_not_of(" \t") + 1);
+                istringstream words(line.substr(colon + 1));
+                args.assign(istream_iterator<string>(words), istream_iterator<string>());
+            }
+            string kind = args.empty() ? "" : TranscriptStore::lowercase(args[0]);
+            bool named = colon != string::npos && colon > start;
+            
+            if (named && kind == "prerequisites" && args.size() == 1) {
+                rule.kind = AuditRule::Kind::Prerequisites;
+            } else if (named && kind == "credits" && args.size() >= 2 && parseNumber(args[1], rule.required)) {
+                rule.kind = AuditRule::Kind::Credits;
+                rule.courses.assign(args.begin() + 2, args.end());
+            } else if (named && kind == "all" && args.size() >= 2) {
+                rule.courses = distinctCourses(args.begin() + 1, args.end());
+                rule.required = (int)rule.courses.size();
+            } else if (named && args.size() >= 3 && parseNumber(args[0], rule.required) &&
+                       TranscriptStore::lowercase(args[1]) == "of") {
+                rule.courses = distinctCourses(args.begin() + 2, args.end());
+                if ((size_t)rule.required > rule.courses.size()) {
+                    error = "line " + to_string(lineNumber) + ": needs more courses than it lists";
+                    return false;
+                }
+            } else {
+                error = "line " + to_string(lineNumber) + ": expected 'name: N of <course>...', 'name: all <course>...', "
+                        "'name: credits N [prefix]...' or 'name: prerequisites'";
+                return false;
+            }
+            rules.push_back(move(rule));
+        }
+        return true;
+    }
+    
+    /**
+     * Compile rules against a transcript store and a catalog
+     * @param transcripts Store to audit; must outlive the engine
+     * @param ruleList Rules every student is checked against
+     * @param catalogId Catalog course ID of a course number, or -1 if unknown
+     * @param catalogPrograms Catalog requirement programs; must outlive the engine
+     * Time Complexity: O(store courses * (rule courses + prefixes))
+     */
+    DegreeAudit(const TranscriptStore& transcripts, vector<AuditRule> ruleList,
+                const function<int(const string&)>& catalogId, RequirementProgramView catalogPrograms)
+        : store(transcripts), rules(move(ruleList)), programs(catalogPrograms) {
+        size_t courses = store.courseCount();
+        vector<vector<uint32_t>> members(courses);
+        for (uint32_t r = 0; r < rules.size(); r++) {
+            const AuditRule& rule = rules[r];
+            if (rule.kind == AuditRule::Kind::Prerequisites) {
+                checksPrerequisites = true;
+            } else if (rule.kind == AuditRule::Kind::Courses) {
+                vector<long> ids;
+                for (const string& courseNumber : rule.courses) ids.push_back(store.findCourse(courseNumber));
+                sort(ids.begin(), ids.end());
+                ids.erase(unique(ids.begin(), ids.end()), ids.end());
+                for (long id : ids) {
+                    if (id >= 0) members[id].push_back(r);
+                }
+            } else {
+                vector<string> prefixes;
+                for (const string& prefix : rule.courses) prefixes.push_back(TranscriptStore::lowercase(prefix));
+                for (size_t c = 0; c < courses; c++) {
+                    string courseNumber = TranscriptStore::lowercase(store.courseNumber(c));
+                    bool matches = prefixes.empty();
+                    for (size_t p = 0; p < prefixes.size() && !matches; p++) {
+                        matches = courseNumber.compare(0, prefixes[p].size(), prefixes[p]) == 0;
+                    }
+                    if (matches) members[c].push_back(r);
+                }
+            }
+        }
+        
+        memberOffsets.assign(courses + 1, 0);
+        catalogIds.resize(courses);
+        for (size_t c = 0; c < courses; c++) {
+            memberOffsets[c + 1] = memberOffsets[c] + (uint32_t)members[c].size();
+            memberRules.insert(memberRules.end(), members[c].begin(), members[c].end());
+            catalogIds[c] = catalogId(store.courseNumber(c));
+        }
+    }
+    
+    size_t ruleCount() const {
+        return rules.size();
+    }
+    
+    /**
+     * Audit one student
+     * @param student Student index in the store
+     * @param scratch Working memory of the calling thread
+     * @param unmet Output: one description per rule not met, in rule order
+     * @return true if every rule is met
+     * Time Complexity: O(rows of the student * rules per course + requirement instructions)
+     */
+    bool audit(uint32_t student, Scratch& scratch, vector<string>& unmet) const {
+        size_t first = store.firstRow(student), last = store.firstRow(student + 1);
+        unmet.clear();
+        fill(scratch.progress.begin(), scratch.progress.end(), 0);
+        if (++scratch.generation == 0) {
+            fill(scratch.countedIn.begin(), scratch.countedIn.end(), 0);
+            scratch.generation = 1;
+        }
+        
+        for (size_t row = first; row < last; row++) {
+            uint32_t course = store.course(row);
+            if (!TranscriptStore::isPassing(store.grade(row)) || scratch.countedIn[course] == scratch.generation) continue;
+            scratch.countedIn[course] = scratch.generation;
+            for (uint32_t m = memberOffsets[course]; m < memberOffsets[course + 1]; m++) {
+                const AuditRule& rule = rules[memberRules[m]];
+                scratch.progress[memberRules[m]] += (rule.kind == AuditRule::Kind::Credits) ? store.credits(row) : 1;
+            }
+        }
+        
+        // Replay the terms in order: a course must be allowed by what was passed before its term
+        size_t violations = 0;
+        size_t firstViolation = 0;
+        if (checksPrerequisites) {
+            for (size_t termStart = first; termStart < last;) {
+                size_t termEnd = termStart;
+                while (termEnd < last && store.term(termEnd) == store.term(termStart)) termEnd++;
+                
+                for (size_t row = termStart; row < termEnd; row++) {
+                    int id = catalogIds[store.course(row)];
+                    if (id >= 0) scratch.enrolled.set(id);
+                }
+                for (size_t row = termStart; row < termEnd; row++) {
+                    int id = catalogIds[store.course(row)];
+                    if (id >= 0 && !PrerequisiteGraph::evaluateProgram(programs.ops + programs.offsets[id],
+                                                                      programs.ops + programs.offsets[id + 1],
+                                                                      scratch.completed, &scratch.enrolled)) {
+                        if (violations++ == 0) firstViolation = row;
+                    }
+                }
+                for (size_t row = termStart; row < termEnd; row++) {
+                    int id = catalogIds[store.course(row)];
+                    if (id < 0) continue;
+                    scratch.enrolled.reset(id);
+                    if (TranscriptStore::isPassing(store.grade(row)) && !scratch.completed.test(id)) {
+                        scratch.completed.set(id);
+                        scratch.passed.push_back(id);
+                    }
+                }
+                termStart = termEnd;
+            }
+            for (int id : scratch.passed) scratch.completed.reset(id);
+            scratch.passed.clear();
+        }
+        
+        for (size_t r = 0; r < rules.size(); r++) {
+            const AuditRule& rule = rules[r];
+            if (rule.kind == AuditRule::Kind::Prerequisites) {
+                if (violations == 0) continue;
+                string description = rule.name + ": " + store.courseNumber(store.course(firstViolation)) +
+                                     " in " + store.termName(store.term(firstViolation));
+                if (violations > 1) description += " and " + to_string(violations - 1) + " more";
+                unmet.push_back(move(description));
+            } else if (scratch.progress[r] < rule.required) {
+                unmet.push_back(rule.name + ": " + to_string(scratch.progress[r]) + " of " + to_string(rule.required) +
+                                (rule.kind == AuditRule::Kind::Credits ? " credits" : ""));
+            }
+        }
+        return unmet.empty();
+    }
+};
+
+
+/**
+ * Versioned Catalog
+ *
+ * The catalog of every term, kept as versions of one persistent hash array
+ * mapped trie keyed by lowercase course number. Each node holds a 32-bit
+ * bitmap of its occupied slots, indexed by five bits of the key's hash per
+ * level, and a packed array of just those slots, each a course record or a
+ * child node. Committing a term's catalog copies only the path from the root to
+ * each course that changed, so unchanged course records, with their
+ * prerequisite groups, and whole unchanged subtries are shared by every term
+ * that has them. Nodes created by the commit in progress are changed in place
+ * rather than copied again, so a commit costs one path copy per changed course.
+ *
+ * A query "as of" a term reads the latest version committed for that term or an
+ * earlier one; terms are ordered by name, like transcript terms. Versions are
+ * never changed once committed, so they can be read from any number of threads
+ * while no commit is running.
+ */
+class CatalogVersions {
+public:
+    /**
+     * Counts of what a commit changed against the version before it
+     */
+    struct CommitStats {
+        size_t courses = 0; // Courses in the new version
+        size_t added = 0; // Courses new in this version
+        size_t changed = 0; // Courses whose name or requirements changed
+        size_t removed = 0; // Courses dropped from the catalog
+    };
+    
+    /**
+     * Memory held by every version together
+     */
+    struct SharingStats {
+        size_t versions = 0; // Committed versions
+        size_t courseEntries = 0; // Courses summed over the versions, as separate copies would hold
+        size_t records = 0; // Distinct course records actually stored
+        size_t nodes = 0; // Distinct trie nodes actually stored
+    };
+    
+private:
+    static constexpr int BITS = 5; // Hash bits consumed per level
+    static constexpr int HASH_BITS = 32; // Below this depth, nodes hold keys whose hashes collide
+    
+    struct Record {
+        string key; // Lowercase course number
+        Course course;
+    };
+    
+    struct Node;
+    
+    struct Slot {
+        uint32_t hash = 0; // Hash of the record's key; unused for child slots
+        shared_ptr<const Record> record; // Course in this slot, or null for a child
+        shared_ptr<Node> child; // Sub-trie in this slot, or null for a record
+    };
+    
+    struct Node {
+        uint64_t edit = 0; // Commit that created the node, which alone may change it in place
+        uint32_t bitmap = 0; // Occupied slot indexes; unused in collision nodes
+        vector<Slot> slots; // Occupied slots in index order, or colliding records
+    };
+    
+    struct Version {
+        string term; // First term the version applies to
+        shared_ptr<Node> root; // Trie root, null for an empty catalog
+        size_t size = 0; // Number of courses
+    };
+    
+    vector<Version> versions; // Sorted by term
+    uint64_t lastEdit = 0; // Edit ID of the latest commit
+    
+    /**
+     * FNV-1a hash of a lowercase course number
+     */
+    static uint32_t hashKey(const string& key) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : key) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+    
+    static uint32_t slotBit(uint32_t hash, int shift) {
+        return 1u << ((hash >> shift) & 31);
+    }
+    
+    static size_t slotIndex(uint32_t bitmap, uint32_t bit) {
+        return (size_t)__builtin_popcount(bitmap & (bit - 1));
+    }
+    
+    static bool sameCourse(const Course& a, const Course& b) {
+        return a.courseNumber == b.courseNumber && a.name == b.name && a.prerequisites == b.prerequisites &&
+               a.prerequisiteGroups == b.prerequisiteGroups && a.corequisiteGroups == b.corequisiteGroups;
+    }
+    
+    /**
+     * Get a node the current commit may change, copying it if an earlier commit made it
+     */
+    static shared_ptr<Node> editable(const shared_ptr<Node>& node, uint64_t edit) {
+        if (node->edit == edit) return node;
+        shared_ptr<Node> copy = make_shared<Node>(*node);
+        copy->edit = edit;
+        return copy;
+    }
+    
+    /**
+     * Find a course in a trie
+     * @param node Root of the trie, may be null
+     * @param hash Hash of key
+     * @param key Lowercase course number
+     * @return The course record, or null if the course is not in the trie
+     * Time Complexity: O(log32 n)
+     */
+    static const Record* find(const Node* node, uint32_t hash, const string& key) {
+        for (int shift = 0; node; shift += BITS) {
+            if (shift >= HASH_BITS) {
+                for (const Slot& slot : node->slots) {
+                    if (slot.record->key == key) return slot.record.get();
+                }
+                return nullptr;
+            }
+            uint32_t bit = slotBit(hash, shift);
+            if (!(node->bitmap & bit)) return nullptr;
+            const Slot& slot = node->slots[slotIndex(node->bitmap, bit)];
+            if (slot.record) return (slot.hash == hash && slot.record->key == key) ? slot.record.get() : nullptr;
+            node = slot.child.get();
+        }
+        return nullptr;
+    }
+    
+    /**
+     * Add or replace a course in a trie, copying the nodes on its path
+     * @param node Root of the (sub-)trie, may be null
+     * @param shift Hash bits consumed above this node
+     * @param hash Hash of the record's key
+     * @param record Course record to store
+     * @param edit Edit ID of the current commit
+     * @return New root of the (sub-)trie
+     */
+    static shared_ptr<Node> insert(shared_ptr<Node> node, int shift, uint32_t hash,
+                                   shared_ptr<const Record> record, uint64_t edit) {
+        if (!node) {
+            node = make_shared<Node>();
+            node->edit = edit;
+        } else {
+            node = editable(node, edit);
+        }
+        
+        if (shift >= HASH_BITS) {
+            for (Slot& slot : node->slots) {
+                if (slot.record->key == record->key) {
+                    slot.record = move(record);
+                    return node;
+                }
+            }
+            node->slots.push_back({hash, move(record), nullptr});
+            return node;
+        }
+        
+        uint32_t bit = slotBit(hash, shift);
+        size_t index = slotIndex(node->bitmap, bit);
+        if (!(node->bitmap & bit)) {
+            node->bitmap |= bit;
+            node->slots.insert(node->slots.begin() + index, Slot{hash, move(record), nullptr});
+            return node;
+        }
+        
+        Slot& slot = node->slots[index];
+        if (slot.child) {
+            slot.child = insert(slot.child, shift + BITS, hash, move(record), edit);
+        } else if (slot.hash == hash && slot.record->key == record->key) {
+            slot.record = move(record);
+        } else {
+            // Two keys share this slot: push both one level down
+            shared_ptr<Node> child = insert(nullptr, shift + BITS, slot.hash, move(slot.record), edit);
+            slot.child = insert(child, shift + BITS, hash, move(record), edit);
+            slot.record = nullptr;
+        }
+        return node;
+    }
+    
+    /**
+     * Remove a course from a trie, copying the nodes on its path
+     * @param node Root of the (sub-)trie, not null
+     * @param shift Hash bits consumed above this node
+     * @param hash Hash of key
+     * @param key Lowercase course number
+     * @param edit Edit ID of the current commit
+     * @return New root of the (sub-)trie, null once it is empty
+     */
+    static shared_ptr<Node> erase(shared_ptr<Node> node, int shift, uint32_t hash, const string& key, uint64_t edit) {
+        node = editable(node, edit);
+        if (shift >= HASH_BITS) {
+            for (size_t i = 0; i < node->slots.size(); i++) {
+                if (node->slots[i].record->key == key) {
+                    node->slots.erase(node->slots.begin() + i);
+                    break;
+                }
+            }
+            return node->slots.empty() ? nullptr : node;
+        }
+        
+        uint32_t bit = slotBit(hash, shift);
+        size_t index = slotIndex(node->bitmap, bit);
+        Slot& slot = node->slots[index];
+        if (slot.child) {
+            slot.child = erase(slot.child, shift + BITS, hash, key, edit);
+            if (slot.child) return node;
+        }
+        node->bitmap &= ~bit;
+        node->slots.erase(node->slots.begin() + index);
+        return node->bitmap ? node : nullptr;
+    }
+    
+    /**
+     * Call a function on every course record in a trie
+     */
+    template <typename Visit>
+    static void forEach(const Node* node, Visit& visit) {
+        if (!node) return;
+        for (const Slot& slot : node->slots) {
+            if (slot.record) visit(*slot.record);
+            else forEach(slot.child.get(), visit);
+        }
+    }
+    
+    /**
+     * Count the records and nodes of a trie not seen in earlier calls
+     */
+    static void countDistinct(const Node* node, unordered_set<const void*>& seen, SharingStats& stats) {
+        if (!node || !seen.insert(node).second) return;
+        stats.nodes++;
+        for (const Slot& slot : node->slots) {
+            if (slot.record) stats.records += seen.insert(slot.record.get()).second;
+            else countDistinct(slot.child.get(), seen, stats);
+        }
+    }
+    
+    /**
+     * Get the version in effect for a term
+     * @return Latest version whose term is not after the given one, or null
+     */
+    const Version* versionAt(const string& term) const {
+        auto it = upper_bound(versions.begin(), versions.end(), term,
+                              [](const string& t, const Version& version) { return t < version.term; });
+        return (it == versions.begin()) ? nullptr : &*(it - 1);
+    }
+    
+public:
+    /**
+     * Commit the whole catalog of a term
+     *
+     * The new version starts from the one in effect for the term and changes only
+     * the courses that differ from it. Committing a term again replaces its version;
+     * versions of later terms are left as they were.
+     *
+     * @param term First term the catalog applies to
+     * @param courses Every course of the catalog; a repeated course number keeps the last
+     * @return What changed against the version before
+     * Time Complexity: O(n + changes * log32 n)
+     */
+    CommitStats commit(const string& term, const vector<Course>& courses) {
+        const Version* base = versionAt(term);
+        Version version{term, base ? base->root : nullptr, base ? base->size : 0};
+        uint64_t edit = ++lastEdit;
+        CommitStats stats;
+        
+        unordered_set<string> present;
+        present.reserve(courses.size());
+        for (const Course& course : courses) {
+            string key = course.courseNumber;
+            transform(key.begin(), key.end(), key.begin(), ::tolower);
+            uint32_t hash = hashKey(key);
+            
+            const Record* old = find(version.root.get(), hash, key);
+            bool seenBefore = !present.insert(key).second;
+            if (old && sameCourse(old->course, course)) continue;
+            if (!old) {
+                stats.added++;
+                version.size++;
+            } else if (!seenBefore) {
+                stats.changed++;
+            }
+            version.root = insert(version.root, 0, hash, make_shared<const Record>(Record{move(key), course}), edit);
+        }
+        
+        if (base) {
+            vector<string> dropped;
+            auto collect = [&](const Record& record) {
+                if (!present.count(record.key)) dropped.push_back(record.key);
+            };
+            forEach(base->root.get(), collect);
+            for (const string& key : dropped) {
+                version.root = erase(version.root, 0, hashKey(key), key, edit);
+            }
+            stats.removed = dropped.size();
+            version.size -= dropped.size();
+        }
+        stats.courses = version.size;
+        
+        auto it = lower_bound(versions.begin(), versions.end(), term,
+                              [](const Version& v, const string& t) { return v.term < t; });
+        if (it != versions.end() && it->term == term) *it = move(version);
+        else versions.insert(it, move(version));
+        return stats;
+    }
+    
+    /**
+     * Check whether any version has been committed
+     */
+    bool empty() const {
+        return versions.empty();
+    }
+    
+    /**
+     * Check whether a term has a catalog, its own or an earlier term's
+     */
+    bool hasTerm(const string& term) const {
+        return versionAt(term) != nullptr;
+    }
+    
+    /**
+     * Look up a course as of a term
+     * @param term Term to read
+     * @param courseNumber Course to find, any case
+     * @return The course, or null if the term's catalog does not have it
+     * Time Complexity: O(log32 n)
+     */
+    const Course* find(const string& term, const string& courseNumber) const {
+        const Version* version = versionAt(term);
+        if (!version) return nullptr;
+        string key = courseNumber;
+        transform(key.begin(), key.end(), key.begin(), ::tolower);
+        const Record* record = find(version->root.get(), hashKey(key), key);
+        return record ? &record->course : nullptr;
+    }
+    
+    /**
+     * Find every course a student may take as of a term, that they have not completed
+     *
+     * Uses the same rules as PrerequisiteGraph::isEligible: every prerequisite
+     * group needs one completed course, and every co-requisite group one completed
+     * or enrolled course.
+     *
+     * @param term Term to read
+     * @param completed Courses the student has completed
+     * @param enrolled Courses the student is taking this semester
+     * @return Eligible courses in natural course number order
+     * Time Complexity: O(n + requirements of the term's catalog)
+     */
+    vector<const Course*> findEligibleCourses(const string& term, const vector<string>& completed,
+                                              const vector<string>& enrolled) const {
+        const Version* version = versionAt(term);
+        if (!version) return {};
+        auto keysOf = [](const vector<string>& courseNumbers) {
+            unordered_set<string> keys;
+            for (string key : courseNumbers) {
+                transform(key.begin(), key.end(), key.begin(), ::tolower);
+                keys.insert(move(key));
+            }
+            return keys;
+        };
+        unordered_set<string> done = keysOf(completed), taking = keysOf(enrolled);
+        string key;
+        auto counts = [&](const string& courseNumber, bool corequisite) {
+            key.assign(courseNumber);
+            transform(key.begin(), key.end(), key.begin(), ::tolower);
+            return done.count(key) || (corequisite && taking.count(key));
+        };
+        auto satisfied = [&](const vector<string>& group, bool corequisite) {
+            return any_of(group.begin(), group.end(), [&](const string& courseNumber) { return counts(courseNumber, corequisite); });
+        };
+        
+        vector<const Course*> eligible;
+        auto check = [&](const Record& record) {
+            const Course& course = record.course;
+            if (done.count(record.key)) return;
+            if (course.prerequisiteGroups.empty()) {
+                for (const string& prerequisite : course.prerequisites) {
+                    if (!counts(prerequisite, false)) return;
+                }
+            }
+            for (const vector<string>& group : course.prerequisiteGroups) {
+                if (!satisfied(group, false)) return;
+            }
+            for (const vector<string>& group : course.corequisiteGroups) {
+                if (!satisfied(group, true)) return;
+            }
+            eligible.push_back(&course);
+        };
+        forEach(version->root.get(), check);
+        
+        vector<RadixSort::NaturalKey> keys;
+        for (size_t i = 0; i < eligible.size(); i++) {
+            keys.push_back(RadixSort::extractKey(eligible[i]->courseNumber, (uint32_t)i));
+        }
+        RadixSort::sortKeys(keys);
+        RadixSort::breakTies(keys, [&](uint32_t i) -> const string& { return eligible[i]->courseNumber; });
+        vector<const Course*> ordered;
+        for (const RadixSort::NaturalKey& key : keys) {
+            ordered.push_back(eligible[key.id]);
+        }
+        return ordered;
+    }
+    
+    /**
+     * Count the memory shared between versions
+     * Time Complexity: O(distinct nodes and records)
+     */
+    SharingStats sharingStats() const {
+        SharingStats stats;
+        unordered_set<const void*> seen;
+        for (const Version& version : versions) {
+            stats.versions++;
+            stats.courseEntries += version.size;
+            countDistinct(version.root.get(), seen, stats);
+        }
+        return stats;
+    }
+};
+
+
+/**
+ * Catalog Edit Log
+ *
+ * Write-ahead log of live edits to a loaded courses file, kept beside it as
+ * <file>.log, so edits survive a restart without rewriting the catalog. After a
+ * 16-byte header (magic "CPLANLOG", version, and the CRC-32 of the courses file
+ * it applies on top of), each record is a 32-bit payload length, a CRC-32 of the
+ * rest of the record, a 64-bit sequence number, and the payload: an operation
+ * byte and its length-prefixed string arguments.
+ *
+ * Edits are queued by append() and written by sync(), which writes everything
+ * queued with one write and one fdatasync, so a run of edits costs one disk flush
+ * (group commit). Callers acknowledge an edit only after a sync() that covers it.
+ *
+ * When the log outgrows the courses file, compaction writes the catalog as a new
+ * courses file on a background thread and starts a fresh log holding only the
+ * edits made meanwhile. It appends a checkpoint record (the new file's CRC and
+ * the last sequence number it includes) before renaming the file into place, so
+ * a crash between the two renames still replays correctly: a log whose header
+ * does not match the courses file is replayed from the checkpoint that does.
+ *
+ * Replay stops at the first torn or corrupt record, which a crash mid-write
+ * leaves at the end, and cuts the log there.
+ */
+class CatalogLog {
+public:
+    /**
+     * Logged operations
+     */
+    enum class Op : uint8_t {
+        AddCourse = 1, // Argument: the course, as a courses file line
+        RemoveCourse = 2, // Argument: course number
+        AddPrerequisite = 3, // Arguments: course number, prerequisite
+        RemovePrerequisite = 4, // Arguments: course number, prerequisite
+        Checkpoint = 5 // Arguments: CRC of a compacted courses file, last sequence number it includes
+    };
+    
+    /**
+     * One logged edit
+     */
+    struct Edit {
+        Op op = Op::AddCourse;
+        vector<string> args;
+    };
+    
+private:
+    static constexpr char MAGIC[8] = {'C', 'P', 'L', 'A', 'N', 'L', 'O', 'G'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 16; // Magic, version, courses file CRC
+    static constexpr size_t RECORD_HEADER_SIZE = 16; // Payload length, CRC, sequence number
+    static constexpr size_t MAX_PAYLOAD = 1 << 24; // Longer lengths can only be corruption
+    static constexpr size_t MIN_COMPACT_BYTES = 1 << 20; // Logs smaller than this are never compacted
+    
+    string snapshotPath; // Courses file the log applies to
+    string logPath; // snapshotPath + ".log"
+    int fd = -1; // Open log, appended to at logBytes
+    uint32_t snapshotCrc = 0; // CRC-32 of the courses file
+    size_t snapshotBytes = 0; // Size of the courses file
+    size_t logBytes = 0; // Bytes written to the log
+    uint64_t lastSequence = 0; // Sequence number of the latest appended edit
+    uint64_t syncedSequence = 0; // Sequence number of the latest edit known to be on disk
+    string pending; // Encoded edits not yet written
+    string failure; // Why the log stopped accepting edits, empty while it works
+    
+    mutex lock; // Guards everything above against the compaction thread
+    thread compactor; // Running or finished compaction
+    atomic<bool> compacting{false};
+    string compactError; // Why the last compaction failed, empty if it did not
+    
+    static void putU32(string& out, uint32_t value) {
+        for (int b = 0; b < 4; b++) out += (char)(value >> (8 * b));
+    }
+    
+    static uint32_t getU32(const char* data) {
+        uint32_t value = 0;
+        for (int b = 3; b >= 0; b--) value = (value << 8) | (unsigned char)data[b];
+        return value;
+    }
+    
+    static string encodeHeader(uint32_t crc) {
+        string header(MAGIC, sizeof(MAGIC));
+        putU32(header, VERSION);
+        putU32(header, crc);
+        return header;
+    }
+    
+    static void encodeRecord(string& out, uint64_t sequence, const Edit& edit) {
+        string body;
+        putU32(body, (uint32_t)sequence);
+        putU32(body, (uint32_t)(sequence >> 32));
+        body += (char)edit.op;
+        for (const string& arg : edit.args) {
+            putU32(body, (uint32_t)arg.size());
+            body += arg;
+        }
+        putU32(out, (uint32_t)(body.size() - 8));
+        putU32(out, crc32(body.data(), body.size()));
+        out += body;
+    }
+    
+    /**
+     * Decode the record at an offset of a log image
+     * @return Offset past the record, or 0 if it is torn or corrupt
+     */
+    static size_t decodeRecord(const string& log, size_t offset, uint64_t& sequence, Edit& edit) {
+        if (log.size() - offset < RECORD_HEADER_SIZE) return 0;
+        size_t length = getU32(log.data() + offset);
+        if (length == 0 || length > MAX_PAYLOAD || log.size() - offset - RECORD_HEADER_SIZE < length) return 0;
+        const char* body = log.data() + offset + 8;
+        if (crc32(body, 8 + length) != getU32(log.data() + offset + 4)) return 0;
+        
+        sequence = getU32(body) | ((uint64_t)getU32(body + 4) << 32);
+        const char* payload = body + 8;
+        edit.op = (Op)payload[0];
+        edit.args.clear();
+        for (size_t i = 1; i < length;) {
+            if (length - i < 4 || length - i - 4 < getU32(payload + i)) return 0;
+            size_t argLength = getU32(payload + i);
+            edit.args.emplace_back(payload + i + 4, argLength);
+            i += 4 + argLength;
+        }
+        return offset + RECORD_HEADER_SIZE + length;
+    }
+    
+    static bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = write(fd, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            data += written;
+            size -= (size_t)written;
+        }
+        return true;
+    }
+    
+    /**
+     * Flush a directory, making renames within it durable
+     */
+    static void syncDirectory(const string& path) {
+        size_t slash = path.rfind('/');
+        string directory = (slash == string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int dirFd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+    
+    /**
+     * Write a file beside its target, flush it and rename it into place
+     * @return false, with a reason in error, if it could not be written
+     */
+    static bool replaceFile(const string& path, const string& contents, string& error) {
+        string temporary = path + ".tmp";
+        int out = ::open(temporary.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+        bool ok = out >= 0 && writeAll(out, contents.data(), contents.size()) && fsync(out) == 0;
+        if (!ok) error = temporary + ": " + strerror(errno);
+        if (out >= 0) ::close(out);
+        if (ok && rename(temporary.c_str(), path.c_str()) != 0) {
+            error = path + ": " + strerror(errno);
+            ok = false;
+        }
+        if (!ok) {
+            unlink(temporary.c_str());
+            return false;
+        }
+        syncDirectory(path);
+        return true;
+    }
+    
+    /**
+     * Write the queued edits and flush them to disk; the caller holds lock
+     */
+    bool syncLocked() {
+        if (pending.empty()) return failure.empty();
+        if (!failure.empty()) return false;
+        if (fd < 0) {
+            string header = encodeHeader(snapshotCrc);
+            fd = ::open(logPath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0 || !writeAll(fd, header.data(), header.size())) {
+                failure = logPath + ": " + strerror(errno);
+                return false;
+            }
+            logBytes = header.size();
+            syncDirectory(logPath);
+        }
+        if (!writeAll(fd, pending.data(), pending.size()) || fdatasync(fd) != 0) {
+            failure = logPath + ": " + strerror(errno);
+            // Cut off any part of the write that landed, so a reload does not replay edits reported lost
+            if (ftruncate(fd, (off_t)logBytes) == 0) fdatasync(fd);
+            return false;
+        }
+        logBytes += pending.size();
+        pending.clear();
+        syncedSequence = lastSequence;
+        return true;
+    }
+    
+    /**
+     * Fold the log into a new courses file; runs on the compaction thread
+     * @param catalog The catalog as a courses file, including every edit up to sequence
+     * @param sequence Last sequence number included in catalog
+     * @param tailStart Log offset of the first edit after sequence
+     */
+    void compact(string catalog, uint64_t sequence, size_t tailStart) {
+        uint32_t crc = crc32(catalog.data(), catalog.size());
+        string error;
+        
+        // Record the checkpoint before the new courses file can be seen
+        append({Op::Checkpoint, {to_string(crc), to_string(sequence)}});
+        bool ok = sync();
+        if (ok && !replaceFile(snapshotPath, catalog, error)) ok = false;
+        
+        if (ok) {
+            lock_guard<mutex> guard(lock);
+            ok = syncLocked();
+            string log = encodeHeader(crc);
+            log.resize(HEADER_SIZE + logBytes - tailStart);
+            for (size_t done = 0; ok && done < logBytes - tailStart;) {
+                ssize_t read = pread(fd, &log[HEADER_SIZE + done], logBytes - tailStart - done, (off_t)(tailStart + done));
+                if (read < 0 && errno == EINTR) continue;
+                if (read <= 0) ok = false;
+                else done += (size_t)read;
+            }
+            if (!ok) error = logPath + ": " + strerror(errno);
+            
+            int newFd = ok && replaceFile(logPath, log, error) ? ::open(logPath.c_str(), O_RDWR | O_APPEND | O_CLOEXEC) : -1;
+            if (newFd >= 0) {
+                ::close(fd);
+                fd = newFd;
+                logBytes = log.size();
+                snapshotCrc = crc;
+                snapshotBytes = catalog.size();
+            } else {
+                // The old log still holds every edit, after a checkpoint that matches the new file
+                if (ok) error = logPath + ": " + strerror(errno);
+                ok = false;
+            }
+        }
+        
+        lock_guard<mutex> guard(lock);
+        compactError = ok ? "" : (error.empty() ? failure : error);
+        compacting = false;
+    }
+    
+public:
+    CatalogLog() {}
+    CatalogLog(const CatalogLog&) = delete;
+    CatalogLog& operator=(const CatalogLog&) = delete;
+    
+    ~CatalogLog() {
+        close();
+    }
+    
+    /**
+     * CRC-32 (IEEE 802.3, as used by zlib), optionally continuing an earlier one
+     * @param data Bytes to checksum
+     * @param size Number of bytes
+     * @param crc CRC of the bytes before these, 0 to start
+     * @return CRC of all the bytes
+     */
+    static uint32_t crc32(const void* data, size_t size, uint32_t crc = 0) {
+        static const array<uint32_t, 256> TABLE = []() {
+            array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++) value = (value >> 1) ^ ((value & 1) ? 0xEDB88320u : 0);
+                table[i] = value;
+            }
+            return table;
+        }();
+        const unsigned char* bytes = (const unsigned char*)data;
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+    
+    /**
+     * Open the log of a courses file and replay it onto the freshly loaded catalog
+     *
+     * A log written for a different version of the file is kept as <log>.stale and
+     * a new one is started.
+     *
+     * @param path Courses file the catalog was loaded from
+     * @param crc CRC-32 of the courses file as loaded
+     * @param bytes Size of the courses file as loaded
+     * @param apply Applies one edit to the catalog, returning false if it no longer applies
+     * @param messages Stream for replay messages
+     * @return Number of edits replayed; error() says if the log could not be opened
+     */
+    size_t open(const string& path, uint32_t crc, size_t bytes, const function<bool(const Edit&)>& apply, ostream& messages) {
+        close();
+        snapshotPath = path;
+        logPath = path + ".log";
+        snapshotCrc = crc;
+        snapshotBytes = bytes;
+        
+        fd = ::open(logPath.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+        if (fd < 0) {
+            // The log is created by the first edit
+            if (errno != ENOENT) failure = logPath + ": " + strerror(errno);
+            return 0;
+        }
+        string log;
+        char chunk[1 << 16];
+        for (ssize_t got; (got = read(fd, chunk, sizeof(chunk))) != 0;) {
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) {
+                failure = logPath + ": " + strerror(errno);
+                return 0;
+            }
+            log.append(chunk, (size_t)got);
+        }
+        
+        if (log.size() >= HEADER_SIZE && (memcmp(log.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+                                          getU32(log.data() + 8) != VERSION)) {
+            failure = logPath + " is not a catalog edit log";
+            return 0;
+        }
+        
+        // Decode every intact record, and find where replay starts
+        vector<pair<uint64_t, Edit>> edits;
+        size_t end = HEADER_SIZE;
+        bool matches = log.size() >= HEADER_SIZE && getU32(log.data() + 12) == crc;
+        uint64_t replayAfter = 0;
+        bool checkpointFound = false;
+        uint64_t sequence = 0;
+        Edit edit;
+        for (size_t next; log.size() > HEADER_SIZE && (next = decodeRecord(log, end, sequence, edit)) != 0; end = next) {
+            if (!matches && edit.op == Op::Checkpoint && edit.args.size() == 2 && edit.args[0] == to_string(crc)) {
+                replayAfter = stoull(edit.args[1]);
+                checkpointFound = true;
+            }
+            lastSequence = sequence;
+            edits.emplace_back(sequence, move(edit));
+        }
+        
+        if (log.size() > HEADER_SIZE && !matches && !checkpointFound) {
+            messages << "Edit log " << logPath << " is for another version of " << path << "; kept as "
+                     << logPath << ".stale." << endl;
+            ::close(fd);
+            fd = -1;
+            rename(logPath.c_str(), (logPath + ".stale").c_str());
+            return open(path, crc, bytes, apply, messages);
+        }
+        if (log.size() < HEADER_SIZE) {
+            // Empty, or torn while its header was written
+            string header = encodeHeader(crc);
+            if (ftruncate(fd, 0) != 0 || !writeAll(fd, header.data(), header.size()) || fdatasync(fd) != 0) {
+                failure = logPath + ": " + strerror(errno);
+                return 0;
+            }
+            end = HEADER_SIZE;
+        } else if (end < log.size()) {
+            messages << "Discarded " << log.size() - end << " torn byte(s) at the end of " << logPath << "." << endl;
+            if (ftruncate(fd, (off_t)end) != 0) {
+                failure = logPath + ": " + strerror(errno);
+                return 0;
+            }
+        }
+        logBytes = end;
+        syncedSequence = lastSequence;
+        
+        size_t replayed = 0;
+        for (const pair<uint64_t, Edit>& entry : edits) {
+            if (entry.second.op == Op::Checkpoint || entry.first <= replayAfter) continue;
+            replayed += apply(entry.second);
+        }
+        if (replayed > 0) {
+            messages << "Replayed " << replayed << " logged edit(s) from " << logPath << "." << endl;
+        }
+        return replayed;
+    }
+    
+    /**
+     * Stop logging, after finishing any compaction and writing queued edits
+     */
+    void close() {
+        if (compactor.joinable()) compactor.join();
+        lock_guard<mutex> guard(lock);
+        if (fd >= 0) {
+            syncLocked();
+            ::close(fd);
+        }
+        fd = -1;
+        snapshotPath.clear();
+        pending.clear();
+        failure.clear();
+        compactError.clear();
+        lastSequence = 0;
+        syncedSequence = 0;
+        logBytes = 0;
+    }
+    
+    /**
+     * Get why the log cannot take edits
+     * @return Reason, or empty if edits can be logged
+     */
+    string error() {
+        lock_guard<mutex> guard(lock);
+        return (snapshotPath.empty() && failure.empty()) ? "no courses file is open for editing" : failure;
+    }
+    
+    /**
+     * Queue an edit; it is durable once a later sync() succeeds
+     * @return Sequence number of the edit
+     */
+    uint64_t append(const Edit& edit) {
+        lock_guard<mutex> guard(lock);
+        encodeRecord(pending, ++lastSequence, edit);
+        return lastSequence;
+    }
+    
+    /**
+     * Write every queued edit with one write and one flush to disk
+     * @return false if the log could not be written; it then takes no more edits
+     */
+    bool sync() {
+        lock_guard<mutex> guard(lock);
+        return syncLocked();
+    }
+    
+    /**
+     * Get the sequence number of the latest edit a sync() has written to disk
+     */
+    uint64_t durableSequence() {
+        lock_guard<mutex> guard(lock);
+        return syncedSequence;
+    }
+    
+    /**
+     * Get the courses file the log applies to
+     * @return Path, or empty if no courses file is open for editing
+     */
+    string coursesPath() {
+        lock_guard<mutex> guard(lock);
+        return snapshotPath;
+    }
+    
+    /**
+     * Check whether edits are waiting for sync()
+     */
+    bool hasPending() {
+        lock_guard<mutex> guard(lock);
+        return !pending.empty();
+    }
+    
+    /**
+     * Check whether the log has grown enough to be worth folding into the courses file
+     */
+    bool wantsCompaction() {
+        lock_guard<mutex> guard(lock);
+        return fd >= 0 && !compacting && logBytes > max(MIN_COMPACT_BYTES, snapshotBytes / 2);
+    }
+    
+    /**
+     * Start folding the log into a new courses file on a background thread
+     *
+     * Edits can go on being logged meanwhile; they are carried over into the new log.
+     *
+     * @param catalog The catalog as a courses file, including every edit appended so far
+     * @return false if the log is not open or a compaction is already running
+     */
+    bool startCompaction(string catalog) {
+        if (compacting || !sync()) return false;
+        if (compactor.joinable()) compactor.join();
+        lock_guard<mutex> guard(lock);
+        if (fd < 0) return false;
+        compacting = true;
+        compactor = thread(&CatalogLog::compact, this, move(catalog), lastSequence, logBytes);
+        return true;
+    }
+    
+    /**
+     * Wait for a running compaction
+     * @return Why the last compaction failed, or empty if it succeeded
+     */
+    string waitForCompaction() {
+        if (compactor.joinable()) compactor.join();
+        lock_guard<mutex> guard(lock);
+        return compactError;
+    }
+};
+
+
+/**
+ * Output Buffer
+ *
+ * Formats text into one large reusable buffer and hands it to the file
+ * descriptor with a single write per buffer-full, instead of a flushing stream
+ * insertion per line. Anything already written through cout is flushed first so
+ * the two never interleave out of order.
+ *
+ * A buffer without a file descriptor (fd -1) only accumulates, for callers that
+ * collect output before sending it elsewhere.
+ */
+class OutputBuffer {
+private:
+    int fd; // Destination, or -1 to accumulate in memory
+    vector<char> buffer; // Formatted bytes not yet written
+    size_t used = 0; // Bytes of buffer in use
+    bool failed = false; // Flag set if a write failed
+    
+    /**
+     * Make room for more bytes, writing out or growing the buffer
+     * @param count Bytes about to be appended
+     */
+    void reserve(size_t count) {
+        if (used + count <= buffer.size()) return;
+        if (fd >= 0) {
+            flush();
+            if (count <= buffer.size()) return;
+        }
+        buffer.resize(max(buffer.size() * 2, used + count));
+    }
+    
+public:
+    /**
+     * Create a buffer over a file descriptor
+     * @param descriptor Destination, or -1 to accumulate in memory
+     * @param capacity Bytes buffered before each write
+     */
+    explicit OutputBuffer(int descriptor, size_t capacity = 64 * 1024) : fd(descriptor), buffer(max<size_t>(capacity, 64)) {
+        if (fd >= 0) cout.flush();
+    }
+    
+    ~OutputBuffer() {
+        flush();
+    }
+    
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+    
+    OutputBuffer& append(const char* data, size_t length) {
+        reserve(length);
+        memcpy(buffer.data() + used, data, length);
+        used += length;
+        return *this;
+    }
+    
+    OutputBuffer& append(const string& text) {
+        return append(text.data(), text.size());
+    }
+    
+    OutputBuffer& append(const char* text) {
+        return append(text, strlen(text));
+    }
+    
+    OutputBuffer& append(char c) {
+        reserve(1);
+        buffer[used++] = c;
+        return *this;
+    }
+    
+    /**
+     * Append an integer in decimal without going through a stream
+     * @param value Integer to append
+     */
+    template <typename Integer>
+    typename enable_if<is_integral<Integer>::value, OutputBuffer&>::type appendNumber(Integer value) {
+        reserve(24);
+        used = to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+        return *this;
+    }
+    
+    /**
+     * Write out everything buffered; a no-op when accumulating in memory
+     * @return false if a write has failed
+     */
+    bool flush() {
+        if (fd < 0) return !failed;
+        size_t written = 0;
+        while (written < used && !failed) {
+            ssize_t result = write(fd, buffer.data() + written, used - written);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) failed = true;
+            else written += result;
+        }
+        used = 0;
+        return !failed;
+    }
+    
+    /**
+     * Get the bytes accumulated since the last flush
+     * @return Pointer to the buffered bytes
+     */
+    const char* data() const {
+        return buffer.data();
+    }
+    
+    /**
+     * Get the number of bytes accumulated since the last flush
+     * @return Byte count
+     */
+    size_t size() const {
+        return used;
+    }
+    
+    /**
+     * Get the number of bytes that can be buffered before a write
+     * @return Byte count
+     */
+    size_t capacity() const {
+        return buffer.size();
+    }
+    
+    /**
+     * Discard the buffered bytes without writing them
+     */
+    void clear() {
+        used = 0;
+    }
+    
+    /**
+     * Discard the buffered bytes past a given size without writing them
+     * @param size Number of bytes to keep
+     */
+    void truncate(size_t size) {
+        used = min(used, size);
+    }
+    
+    /**
+     * Send other buffers' contents after this one's, in order
+     *
+     * Anything buffered here is written first, then the parts are written with
+     * gathered writes of up to IOV_MAX buffers each, so no bytes are copied. When
+     * accumulating in memory the parts are appended instead.
+     *
+     * @param parts Buffers to send, typically filled by worker threads
+     * @return false if a write has failed
+     */
+    bool writeParts(const vector<unique_ptr<OutputBuffer>>& parts) {
+        if (fd < 0) {
+            for (const auto& part : parts) append(part->data(), part->size());
+            return !failed;
+        }
+        
+        flush();
+        vector<iovec> pending;
+        for (const auto& part : parts) {
+            if (part->size() > 0) pending.push_back({const_cast<char*>(part->data()), part->size()});
+        }
+        
+        size_t next = 0;
+        while (next < pending.size() && !failed) {
+            int count = (int)min<size_t>(pending.size() - next, IOV_MAX);
+            ssize_t result = writev(fd, &pending[next], count);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) {
+                failed = true;
+                break;
+            }
+            
+            // Skip whole buffers written, then advance into a partly written one
+            size_t written = result;
+            while (next < pending.size() && written >= pending[next].iov_len) {
+                written -= pending[next++].iov_len;
+            }
+            if (written > 0) {
+                pending[next].iov_base = static_cast<char*>(pending[next].iov_base) + written;
+                pending[next].iov_len -= written;
+            }
+        }
+        return !failed;
+    }
+};
+
+
+/**
+ * Render a range of items into an output buffer, split across worker threads
+ *
+ * Items are rendered in batches: each worker formats one contiguous slice of the
+ * batch into its own buffer, then the buffers are written in slice order, so the
+ * bytes match rendering the whole range serially while memory stays bounded by
+ * the batch. Short ranges, or a single worker, render directly into out.
+ *
+ * @param out Buffer the output belongs to
+ * @param count Number of items
+ * @param renderRange Renders items [begin, end) into the buffer it is given
+ * @return false if a write has failed
+ */
+bool renderParallel(OutputBuffer& out, size_t count, const function<void(OutputBuffer&, size_t, size_t)>& renderRange)
+{
+    const size_t SLICE = 4096; // Items per worker per batch
+    size_t workers = workerCount();
+    if (workers == 1 || count < 2 * SLICE) {
+        renderRange(out, 0, count);
+        return true;
+    }
+    
+    vector<unique_ptr<OutputBuffer>> slices;
+    for (size_t w = 0; w < workers; w++) {
+        slices.emplace_back(new OutputBuffer(-1, 1024 * 1024));
+    }
+    
+    bool ok = true;
+    for (size_t batchStart = 0; batchStart < count && ok; batchStart += workers * SLICE) {
+        size_t batchSize = min(count - batchStart, workers * SLICE);
+        for (auto& slice : slices) slice->clear();
+        
+        parallelFor(batchSize, [&](size_t begin, size_t end, int worker) {
+            renderRange(*slices[worker], batchStart + begin, batchStart + end);
+        }, 0);
+        ok = out.writeParts(slices);
+    }
+    return ok;
+}
+
+
+/**
+ * Formats for course output
+ */
+enum class OutputFormat {
+    Text, // Human-readable, as printed by the menu
+    Json, // One JSON array (or object, for a single lookup)
+    Ndjson, // One JSON object per line
+    Csv // RFC 4180 rows under a header row
+};
+
+
+/**
+ * Course Serializer
+ *
+ * Streams course records into an OutputBuffer as JSON, NDJSON or CSV. Strings
+ * are escaped in place by copying the runs between special characters, and
+ * numbers go through the buffer's integer formatting, so serializing a record
+ * allocates nothing.
+ *
+ * Course records carry the number, the name, and the prerequisite and
+ * co-requisite groups. JSON writes groups as arrays of arrays; CSV writes them in
+ * the courses file syntax, with groups separated by ';' and alternatives by '|'.
+ * Valued records, from graph queries, carry the number, the name and one integer
+ * (a hop distance, a level or a blocked-course count). Text output renders courses
+ * exactly as printCourse does.
+ */
+class CourseSerializer {
+public:
+    /**
+     * Kind of record being written
+     */
+    enum class Records {
+        Courses, // Whole courses
+        Reached, // Courses found by a graph query, with their hop distance
+        Levels, // Courses with their level, the earliest semester they can be taken
+        Blocked, // Courses with the number of courses they transitively block
+        Audits // Students with the degree rules they have not met
+    };
+    
+    /**
+     * Start a serialized response
+     * @param buffer Buffer to write into
+     * @param outputFormat Format to write
+     * @param recordKind Kind of record that follows
+     * @param list false to write a single JSON object instead of an array
+     * @param firstRecord Index of the first record written, when continuing a response
+     *                    rendered in slices; the opening is only written for record 0
+     */
+    CourseSerializer(OutputBuffer& buffer, OutputFormat outputFormat, Records recordKind, bool list = true,
+                     size_t firstRecord = 0)
+        : out(buffer), format(outputFormat), kind(recordKind), isList(list), records(firstRecord) {
+        if (records > 0) {
+            return;
+        } else if (format == OutputFormat::Csv) {
+            if (kind == Records::Courses) {
+                out.append("courseNumber,name,prerequisites,corequisites\n");
+            } else if (kind == Records::Audits) {
+                out.append("student,complete,unmet\n");
+            } else {
+                out.append("courseNumber,name,").append(valueName()).append('\n');
+            }
+        } else if (format == OutputFormat::Json && isList) {
+            out.append('[');
+        }
+    }
+    
+    /**
+     * Write one course
+     * @param course Course to write
+     */
+    void write(const Course& course) {
+        switch (format) {
+            case OutputFormat::Text:
+                renderText(course);
+                break;
+            case OutputFormat::Csv:
+                appendCsv(course.courseNumber);
+                out.append(',');
+                appendCsv(course.name);
+                out.append(',');
+                appendCsvGroups(course.prerequisiteGroups, course.prerequisites);
+                out.append(',');
+                appendCsvGroups(course.corequisiteGroups, EMPTY);
+                out.append('\n');
+                break;
+            default:
+                beginObject();
+                out.append("{\"courseNumber\":");
+                appendJson(course.courseNumber);
+                out.append(",\"name\":");
+                appendJson(course.name);
+                out.append(",\"prerequisites\":");
+                appendJsonGroups(course.prerequisiteGroups, course.prerequisites);
+                out.append(",\"corequisites\":");
+                appendJsonGroups(course.corequisiteGroups, EMPTY);
+                out.append('}');
+                endObject();
+        }
+        records++;
+    }
+    
+    /**
+     * Write one course with its value for a Reached, Levels or Blocked response
+     * @param courseNumber Course to write
+     * @param name Name of the course, empty if unknown
+     * @param value Hop distance, level or blocked-course count
+     */
+    void write(const string& courseNumber, const string& name, int value) {
+        switch (format) {
+            case OutputFormat::Text:
+                out.append(courseNumber).append(", ").append(name).append(" (").append(valueName()).append(": ");
+                out.appendNumber(value).append(")\n");
+                break;
+            case OutputFormat::Csv:
+                appendCsv(courseNumber);
+                out.append(',');
+                appendCsv(name);
+                out.append(',').appendNumber(value).append('\n');
+                break;
+            default:
+                beginObject();
+                out.append("{\"courseNumber\":");
+                appendJson(courseNumber);
+                out.append(",\"name\":");
+                appendJson(name);
+                out.append(",\"").append(valueName()).append("\":").appendNumber(value).append('}');
+                endObject();
+        }
+        records++;
+    }
+    
+    /**
+     * Write one student's degree audit for an Audits response
+     * @param student Student name
+     * @param unmet Rules the student has not met, empty if the degree is complete
+     */
+    void write(const string& student, const vector<string>& unmet) {
+        switch (format) {
+            case OutputFormat::Text:
+                out.append(student).append(unmet.empty() ? ": complete" : ": incomplete (");
+                for (size_t i = 0; i < unmet.size(); i++) {
+                    out.append(i > 0 ? "; " : "").append(unmet[i]);
+                }
+                out.append(unmet.empty() ? "\n" : ")\n");
+                break;
+            case OutputFormat::Csv: {
+                appendCsv(student);
+                out.append(unmet.empty() ? ",true," : ",false,");
+                string joined;
+                for (size_t i = 0; i < unmet.size(); i++) {
+                    if (i > 0) joined += ';';
+                    joined += unmet[i];
+                }
+                appendCsv(joined);
+                out.append('\n');
+                break;
+            }
+            default:
+                beginObject();
+                out.append("{\"student\":");
+                appendJson(student);
+                out.append(unmet.empty() ? ",\"complete\":true,\"unmet\":[" : ",\"complete\":false,\"unmet\":[");
+                for (size_t i = 0; i < unmet.size(); i++) {
+                    if (i > 0) out.append(',');
+                    appendJson(unmet[i]);
+                }
+                out.append("]}");
+                endObject();
+        }
+        records++;
+    }
+    
+    /**
+     * Write a response holding a single named count, such as the courses loaded
+     * @param buffer Buffer to write into
+     * @param format Format to write
+     * @param name Name of the count
+     * @param value Count to write
+     */
+    static void writeCount(OutputBuffer& buffer, OutputFormat format, const char* name, size_t value) {
+        switch (format) {
+            case OutputFormat::Text:
+                buffer.append(name).append(": ").appendNumber(value).append('\n');
+                break;
+            case OutputFormat::Csv:
+                buffer.append(name).append('\n').appendNumber(value).append('\n');
+                break;
+            default:
+                buffer.append("{\"").append(name).append("\":").appendNumber(value).append("}\n");
+        }
+    }
+    
+    /**
+     * Write an error response in place of a command's result
+     * @param buffer Buffer to write into
+     * @param format Format to write
+     * @param message Description of the error
+     */
+    static void writeError(OutputBuffer& buffer, OutputFormat format, const string& message) {
+        CourseSerializer serializer(buffer, format, Records::Courses, false, 1);
+        switch (format) {
+            case OutputFormat::Text:
+                buffer.append("Error: ").append(message).append('\n');
+                break;
+            case OutputFormat::Csv:
+                buffer.append("error\n");
+                serializer.appendCsv(message);
+                buffer.append('\n');
+                break;
+            default:
+                buffer.append("{\"error\":");
+                serializer.appendJson(message);
+                buffer.append("}\n");
+        }
+    }
+    
+    /**
+     * Close the response, ending a JSON array
+     */
+    void finish() {
+        if (format == OutputFormat::Json && isList) {
+            out.append(records > 0 ? "\n]\n" : "]\n");
+        }
+    }
+    
+private:
+    static const vector<string> EMPTY; // Stand-in for the flat list of co-requisites, which has none
+    static const unsigned char JSON_ESCAPE = 1; // Character must be escaped in a JSON string
+    static const unsigned char CSV_QUOTE = 2; // Character forces a CSV field to be quoted
+    static const array<unsigned char, 256> SPECIAL; // Character -> JSON_ESCAPE | CSV_QUOTE flags
+    
+    OutputBuffer& out;
+    OutputFormat format;
+    Records kind;
+    bool isList;
+    size_t records; // Records written so far
+    
+    const char* valueName() const {
+        switch (kind) {
+            case Records::Levels: return "level";
+            case Records::Blocked: return "blocked";
+            default: return "hops";
+        }
+    }
+    
+    void beginObject() {
+        if (format == OutputFormat::Json && isList) {
+            out.append(records > 0 ? ",\n" : "\n");
+        }
+    }
+    
+    void endObject() {
+        if (format == OutputFormat::Ndjson || !isList) {
+            out.append('\n');
+        }
+    }
+    
+    /**
+     * Append a JSON string literal, escaping quotes, backslashes and control characters
+     * @param value String to append
+     */
+    void appendJson(const string& value) {
+        static const char HEX[] = "0123456789abcdef";
+        out.append('"');
+        size_t start = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            unsigned char c = (unsigned char)value[i];
+            if (!(SPECIAL[c] & JSON_ESCAPE)) continue;
+            
+            out.append(value.data() + start, i - start);
+            start = i + 1;
+            switch (c) {
+                case '"': out.append("\\\""); break;
+                case '\\': out.append("\\\\"); break;
+                case '\n': out.append("\\n"); break;
+                case '\r': out.append("\\r"); break;
+                case '\t': out.append("\\t"); break;
+                default:
+                    out.append("\\u00").append(HEX[c >> 4]).append(HEX[c & 0xF]);
+            }
+        }
+        out.append(value.data() + start, value.size() - start).append('"');
+    }
+    
+    /**
+     * Append requirement groups as a JSON array of arrays
+     * @param groups Requirement groups
+     * @param flat Flat requirement list, each its own group when groups is empty
+     */
+    void appendJsonGroups(const vector<vector<string>>& groups, const vector<string>& flat) {
+        out.append('[');
+        if (groups.empty()) {
+            for (size_t i = 0; i < flat.size(); i++) {
+                out.append(i > 0 ? ",[" : "[");
+                appendJson(flat[i]);
+                out.append(']');
+            }
+        }
+        for (size_t i = 0; i < groups.size(); i++) {
+            out.append(i > 0 ? ",[" : "[");
+            for (size_t j = 0; j < groups[i].size(); j++) {
+                if (j > 0) out.append(',');
+                appendJson(groups[i][j]);
+            }
+            out.append(']');
+        }
+        out.append(']');
+    }
+    
+    /**
+     * Append a CSV field, quoting it only if it contains a comma, quote or line break
+     * @param value Field to append
+     */
+    void appendCsv(const string& value) {
+        if (!needsCsvQuotes(value)) {
+            out.append(value);
+            return;
+        }
+        out.append('"');
+        size_t start = 0;
+        for (size_t quote = value.find('"'); quote != string::npos; quote = value.find('"', quote + 1)) {
+            out.append(value.data() + start, quote + 1 - start).append('"');
+            start = quote + 1;
+        }
+        out.append(value.data() + start, value.size() - start).append('"');
+    }
+    
+    /**
+     * Append requirement groups as one CSV field in courses file syntax
+     * @param groups Requirement groups
+     * @param flat Flat requirement list, each its own group when groups is empty
+     */
+    void appendCsvGroups(const vector<vector<string>>& groups, const vector<string>& flat) {
+        const vector<vector<string>>* source = groups.empty() ? nullptr : &groups;
+        size_t groupCount = source ? groups.size() : flat.size();
+        
+        bool quoted = false;
+        for (size_t i = 0; i < groupCount; i++) {
+            if (!source) {
+                quoted |= needsCsvQuotes(flat[i]);
+                continue;
+            }
+            for (const string& alternative : groups[i]) quoted |= needsCsvQuotes(alternative);
+        }
+        if (quoted) {
+            appendCsv(joinGroups(groups, flat));
+            return;
+        }
+        
+        for (size_t i = 0; i < groupCount; i++) {
+            if (i > 0) out.append(';');
+            if (!source) {
+                out.append(flat[i]);
+                continue;
+            }
+            for (size_t j = 0; j < groups[i].size(); j++) {
+                if (j > 0) out.append('|');
+                out.append(groups[i][j]);
+            }
+        }
+    }
+    
+    /**
+     * Join requirement groups into courses file syntax, for the rare field that must be quoted
+     * @param groups Requirement groups
+     * @param flat Flat requirement list, each its own group when groups is empty
+     * @return Joined field
+     */
+    static string joinGroups(const vector<vector<string>>& groups, const vector<string>& flat) {
+        string field;
+        for (size_t i = 0; i < groups.size(); i++) {
+            for (size_t j = 0; j < groups[i].size(); j++) field += (j > 0 ? "|" : "") + groups[i][j];
+            if (i + 1 < groups.size()) field += ';';
+        }
+        for (size_t i = 0; groups.empty() && i < flat.size(); i++) field += (i > 0 ? ";" : "") + flat[i];
+        return field;
+    }
+    
+    /**
+     * Check if a CSV field must be quoted
+     * @param value Field to check
+     * @return true if it contains a comma, quote or line break
+     */
+    static bool needsCsvQuotes(const string& value) {
+        unsigned char flags = 0;
+        for (char c : value) flags |= SPECIAL[(unsigned char)c];
+        return flags & CSV_QUOTE;
+    }
+    
+    static array<unsigned char, 256> specialCharacters() {
+        array<unsigned char, 256> table{};
+        for (int c = 0; c < 0x20; c++) table[c] = JSON_ESCAPE;
+        table['"'] = JSON_ESCAPE | CSV_QUOTE;
+        table['\\'] = JSON_ESCAPE;
+        table[','] = CSV_QUOTE;
+        table['\r'] |= CSV_QUOTE;
+        table['\n'] |= CSV_QUOTE;
+        return table;
+    }
+    
+    void renderText(const Course& course);
+};
+
+const vector<string> CourseSerializer::EMPTY;
+const array<unsigned char, 256> CourseSerializer::SPECIAL = CourseSerializer::specialCharacters();
+
+
+// Global data structures
+CourseHashTable courseHashTable; // Hash table for O(1) course lookup
+PrerequisiteGraph prereqGraph; // Graph for prerequisite relationships
+CatalogIndexes catalogIndexes; // Maintained secondary orderings of the catalog
+bool dataLoaded = false; // Flag to track if courses are loaded
+CatalogImage catalogImage; // Published catalog attached in place of a loaded one, if any
+TranscriptStore transcriptStore; // Student course histories for degree audits
+CatalogVersions catalogVersions; // Catalog of each term, sharing unchanged courses
+CatalogLog catalogLog; // Write-ahead log of live edits to the loaded courses file
+
+
+/**
+ * Parse a comma-separated string into a vector of strings
+ *
+ * Call it as ::format, so that argument-dependent lookup cannot pick std::format.
+ *
+ * @param s Input string to parse
+ * @param del Delimiter to split on (default: comma)
+ * @return Vector of parsed string tokens
+ */
+vector<string> format(const string s, const string del = ",")
+{
+    vector<string> result;
+    size_t start = 0, end = s.find(del);
+    while( end != string::npos)
+    {
+        result.push_back(s.substr(start, end - start));
+        start = end + del.size();
+        end = s.find(del, start);
+    }
+    result.push_back(s.substr(start, end - start));
+    return result;
+}
+
+
+/**
+ * Parse one catalog line into a course
+ *
+ * Each field after the course name is one requirement group: "MATH201|MATH210"
+ * accepts either course, and a leading '+' marks a co-requisite group. A group
+ * with an empty alternative, such as "MATH201|", makes the whole line invalid.
+ *
+ * @param line Line of the courses file
+ * @return Parsed course, with an empty course number if the line is invalid
+ */
+Course parseCourseLine(const string& line)
+{
+    Course course;
+    vector<string> info = ::format(line);
+
+    course.courseNumber = info[0];
+    course.name = info.size() > 1 ? info[1] : "";
+
+    for(size_t i = 2; i < info.size(); i++)
+    {
+        string field = info[i];
+        bool corequisite = !field.empty() && field[0] == '+';
+        if (corequisite) field.erase(0, 1);
+        if (field.empty()) continue;
+        
+        vector<string> alternatives = ::format(field, "|");
+        if (find(alternatives.begin(), alternatives.end(), "") != alternatives.end()) {
+            return Course();
+        }
+        if (corequisite) {
+            course.corequisiteGroups.push_back(alternatives);
+        } else {
+            course.prerequisiteGroups.push_back(alternatives);
+            course.prerequisites.insert(course.prerequisites.end(), alternatives.begin(), alternatives.end());
+        }
+    }
+    return course;
+}
+
+
+/**
+ * Load courses from file and populate  data structures
+ *
+ * Enhancements:
+ * 1. Populates hash table for O(1) lookups
+ * 2. Builds prerequisite graph for relationship analysis
+ * 3. Orders the catalog in natural course number order with a radix sort
+ *
+ * A course listed more than once is loaded once, with its last definition.
+ *
+ * @param path Courses file to read
+ * @param messages Stream for load status messages
+ * @return View over the loaded courses in course number order
+ * Time Complexity: O(n) average, the radix sort being linear
+ */
+CourseOrdering loadCoursesFile(const string& path = "courses.txt", ostream& messages = cout)
+{
+    ifstream fin(path, ios::in);
+    CourseOrdering courses;
+    string line;
+    bool entered = false;
+    
+    // Clear existing data structure
+    courseHashTable = CourseHashTable();
+    prereqGraph = PrerequisiteGraph();
+    catalogIndexes.invalidate();
+    catalogImage.detach();
+    catalogLog.close();
+
+    while (getline(fin, line))
+    {
+        if(line == "-1") break;
+        entered = true;
+
+        Course course = parseCourseLine(line);
+        if (course.courseNumber.empty() && !line.empty()) {
+            messages << "Skipping invalid course line: " << line << endl;
+            continue;
+        }
+        courseHashTable.insert(course);
+        prereqGraph.addCourse(course);
+    }
+    
+    // If the while loop was never entered, this means the file was never read.
+    // If it was entered but the hash table is empty, the file is empty.
+    if (!entered) {
+            messages << "Could not access courses file. Please check if loaded properly." << endl;
             dataLoaded = false;
-        } else if (courses.size() == 0) {
-            std::cout << "Courses file appears to be empty." << endl;
+        } else if (courseHashTable.empty()) {
+            messages << "Courses file appears to be empty." << endl;
             dataLoaded = false;
         } else {
-            MergeSort::mergeSort(courses, 0, courses.size() - 1);
-            dataLoaded = true;
+            courses = RadixSort::orderNaturally(courseHashTable);
+            // From here on, edits are checked for prerequisite cycles
+            prereqGraph.computeLevels();
+            dataLoaded = true;
+            
+            messages << "Data successfully loaded.\n" << endl;
+        }
+    
+    fin.close();
+    return courses;
+}
+
+
+/**
+ * Attach to a catalog image published by another process, in place of loading a file
+ *
+ * Batch queries then read the shared image; the loaded catalog is cleared.
+ *
+ * @param name Name the image was published under
+ * @param messages Stream for status messages
+ * @return true if the image was attached
+ */
+bool attachCatalogImage(const string& name, ostream& messages)
+{
+    catalogLog.close();
+    courseHashTable = CourseHashTable();
+    prereqGraph = PrerequisiteGraph();
+    catalogIndexes.invalidate();
+    
+    string error;
+    dataLoaded = catalogImage.attach(name, error);
+    if (!dataLoaded) {
+        messages << "Could not attach catalog " << name << ": " << error << "." << endl;
+    }
+    return dataLoaded;
+}
+
+
+/**
+ * Convert string to lowercase for case-insensitive course number comparisons
+ * @param str Input string to convert
+ * @return Lowercase version of input string
+ */
+string toLowerCase(string str)
+{
+    transform(str.begin(), str.end(), str.begin(), ::tolower);
+    return str;
+}
+
+
+/**
+ * Get a maintained secondary ordering of the loaded catalog
+ *
+ * Indexes are built on first use and then kept current by the catalog edit
+ * functions below.
+ *
+ * @param order Ordering to return
+ * @return View over the loaded courses in that order
+ * Time Complexity: O(n log n) on first use, O(n) afterwards
+ */
+CourseOrdering getCatalogOrdering(CatalogOrder order)
+{
+    if (!catalogIndexes.isBuilt()) {
+        catalogIndexes.rebuild(courseHashTable, prereqGraph);
+    }
+    return catalogIndexes.ordering(courseHashTable, order);
+}
+
+
+/**
+ * Get one page of a maintained ordering of the loaded catalog
+ *
+ * Department order matches the course list printed by the menu, so page N of the
+ * listing is getCatalogPage(CatalogOrder::Department, N * pageSize, pageSize).
+ *
+ * @param order Ordering to read
+ * @param offset Position of the first course on the page
+ * @param limit Maximum number of courses on the page
+ * @return View over the courses on the page
+ * Time Complexity: O(limit) once the indexes are built
+ */
+CourseOrdering getCatalogPage(CatalogOrder order, size_t offset, size_t limit)
+{
+    if (!catalogIndexes.isBuilt()) {
+        catalogIndexes.rebuild(courseHashTable, prereqGraph);
+    }
+    return catalogIndexes.page(courseHashTable, order, offset, limit);
+}
+
+
+/**
+ * Get the next page of a maintained ordering of the loaded catalog
+ * @param cursor Continuation point, advanced past the returned page
+ * @param limit Maximum number of courses on the page
+ * @return View over the courses on the page
+ * Time Complexity: O(log n + limit) once the indexes are built
+ */
+CourseOrdering getNextCatalogPage(CatalogCursor& cursor, size_t limit)
+{
+    if (!catalogIndexes.isBuilt()) {
+        catalogIndexes.rebuild(courseHashTable, prereqGraph);
+    }
+    return catalogIndexes.nextPage(courseHashTable, cursor, limit);
+}
+
+
+/**
+ * Add or replace a course in the loaded catalog
+ * @param course Course to add
+ * @return false if its prerequisites would create a cycle
+ */
+bool addCatalogCourse(const Course& course)
+{
+    if (!prereqGraph.addCourse(course)) {
+        return false;
+    }
+    courseHashTable.insert(course);
+    catalogIndexes.refresh(courseHashTable, prereqGraph, course.courseNumber);
+    return true;
+}
+
+
+/**
+ * Remove a course from the loaded catalog
+ * @param courseNumber Course to remove
+ * @return false if the course is not in the catalog
+ */
+bool removeCatalogCourse(const string& courseNumber)
+{
+    long id = courseHashTable.recordId(courseNumber);
+    if (id < 0) {
+        return false;
+    }
+    
+    catalogIndexes.remove((uint32_t)id);
+    courseHashTable.erase(courseNumber);
+    prereqGraph.removeCourse(courseNumber);
+    catalogIndexes.refresh(courseHashTable, prereqGraph, courseNumber);
+    return true;
+}
+
+
+/**
+ * Make a course in the loaded catalog require another course
+ * @param courseNumber Course gaining the prerequisite
+ * @param prereqNumber Prerequisite to add, as its own requirement group
+ * @return false if the course is unknown or the edge would create a cycle
+ */
+bool addCatalogPrerequisite(const string& courseNumber, const string& prereqNumber)
+{
+    Course* course = courseHashTable.find(courseNumber);
+    if (!course || !prereqGraph.addEdge(courseNumber, prereqNumber)) {
+        return false;
+    }
+    
+    Course updated = *course;
+    if (updated.prerequisiteGroups.empty()) {
+        for (const string& prereq : updated.prerequisites) {
+            updated.prerequisiteGroups.push_back(vector<string>(1, prereq));
+        }
+    }
+    
+    string prereqKey = toLowerCase(prereqNumber);
+    bool present = false;
+    for (const vector<string>& group : updated.prerequisiteGroups) {
+        present |= group.size() == 1 && toLowerCase(group[0]) == prereqKey;
+    }
+    if (!present) {
+        updated.prerequisiteGroups.push_back(vector<string>(1, prereqNumber));
+        updated.prerequisites.push_back(prereqNumber);
+    }
+    
+    courseHashTable.insert(updated);
+    catalogIndexes.refresh(courseHashTable, prereqGraph, courseNumber);
+    return true;
+}
+
+
+/**
+ * Stop a course in the loaded catalog from requiring another course
+ * @param courseNumber Course losing the prerequisite
+ * @param prereqNumber Prerequisite to remove from every group
+ * @return false if the course did not require the prerequisite
+ */
+bool removeCatalogPrerequisite(const string& courseNumber, const string& prereqNumber)
+{
+    Course* course = courseHashTable.find(courseNumber);
+    if (!course || !prereqGraph.removeEdge(courseNumber, prereqNumber)) {
+        return false;
+    }
+    
+    Course updated = *course;
+    if (updated.prerequisiteGroups.empty()) {
+        for (const string& prereq : updated.prerequisites) {
+            updated.prerequisiteGroups.push_back(vector<string>(1, prereq));
+        }
+    }
+    
+    string prereqKey = toLowerCase(prereqNumber);
+    vector<vector<string>> groups;
+    updated.prerequisites.clear();
+    for (vector<string> group : updated.prerequisiteGroups) {
+        group.erase(remove_if(group.begin(), group.end(), [&](const string& alternative) {
+            return toLowerCase(alternative) == prereqKey;
+        }), group.end());
+        if (group.empty()) continue;
+        updated.prerequisites.insert(updated.prerequisites.end(), group.begin(), group.end());
+        groups.push_back(group);
+    }
+    updated.prerequisiteGroups = groups;
+    
+    courseHashTable.insert(updated);
+    catalogIndexes.refresh(courseHashTable, prereqGraph, courseNumber);
+    return true;
+}
+
+
+/**
+ * Format a course as a line of the courses file, the inverse of parseCourseLine
+ * @param course Course to format
+ * @return Line without a line break
+ */
+string formatCourseLine(const Course& course)
+{
+    string line = course.courseNumber + "," + course.name;
+    auto appendGroups = [&](const vector<vector<string>>& groups, const char* prefix) {
+        for (const vector<string>& group : groups) {
+            line.append(",").append(prefix);
+            for (size_t i = 0; i < group.size(); i++) {
+                if (i > 0) line += '|';
+                line += group[i];
+            }
+        }
+    };
+    if (course.prerequisiteGroups.empty()) {
+        for (const string& prerequisite : course.prerequisites) {
+            line.append(",").append(prerequisite);
+        }
+    }
+    appendGroups(course.prerequisiteGroups, "");
+    appendGroups(course.corequisiteGroups, "+");
+    return line;
+}
+
+
+/**
+ * Format the loaded catalog as a courses file, in the order courses were added
+ * @return Contents of the file
+ */
+string formatCatalogSnapshot()
+{
+    string text;
+    for (size_t id = 0; id < courseHashTable.recordCount(); id++) {
+        if (courseHashTable.isRemoved(id)) continue;
+        text.append(formatCourseLine(courseHashTable.getCourse(id))).append("\n");
+    }
+    return text;
+}
+
+
+/**
+ * Apply one edit from the catalog edit log to the loaded catalog
+ * @param edit Logged edit
+ * @return false if the edit does not apply to the catalog
+ */
+bool applyCatalogEdit(const CatalogLog::Edit& edit)
+{
+    switch (edit.op) {
+        case CatalogLog::Op::AddCourse:
+            return edit.args.size() == 1 && addCatalogCourse(parseCourseLine(edit.args[0]));
+        case CatalogLog::Op::RemoveCourse:
+            return edit.args.size() == 1 && removeCatalogCourse(edit.args[0]);
+        case CatalogLog::Op::AddPrerequisite:
+            return edit.args.size() == 2 && addCatalogPrerequisite(edit.args[0], edit.args[1]);
+        case CatalogLog::Op::RemovePrerequisite:
+            return edit.args.size() == 2 && removeCatalogPrerequisite(edit.args[0], edit.args[1]);
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * Load a courses file with the edits logged against it since it was written
+ *
+ * Later edits to the catalog are logged beside the file (see CatalogLog).
+ *
+ * @param path Courses file to read
+ * @param messages Stream for load status messages
+ * @return View over the loaded courses in course number order
+ */
+CourseOrdering loadCatalog(const string& path, ostream& messages)
+{
+    CourseOrdering courses = loadCoursesFile(path, messages);
+    if (!dataLoaded) {
+        return courses;
+    }
+    
+    // The log records which version of the file it applies to by checksum
+    uint32_t crc = 0;
+    size_t bytes = 0;
+    ifstream file(path, ios::binary);
+    char chunk[1 << 16];
+    while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+        crc = CatalogLog::crc32(chunk, (size_t)file.gcount(), crc);
+        bytes += (size_t)file.gcount();
+    }
+    if (catalogLog.open(path, crc, bytes, applyCatalogEdit, messages) > 0) {
+        courses = RadixSort::orderNaturally(courseHashTable);
+    }
+    string error = catalogLog.error();
+    if (!error.empty()) {
+        messages << "Edits cannot be logged: " << error << "." << endl;
+    }
+    return courses;
+}
+
+
+/**
+ * Render requirement groups as a comma-separated list, with alternatives joined by "or"
+ * @param out Buffer to render into
+ * @param groups Requirement groups to render
+ */
+void renderRequirementGroups(OutputBuffer& out, const vector<vector<string>>& groups)
+{
+    for (size_t i = 0; i < groups.size(); ++i) {
+        for (size_t j = 0; j < groups[i].size(); ++j) {
+            out.append(groups[i][j]);
+            if (j < groups[i].size() - 1) {
+                out.append(" or ", 4);
+            }
+        }
+        
+        // Render a comma after each group except for the last one
+        if (i < groups.size() - 1) {
+            out.append(", ", 2);
+        }
+    }
+}
+
+
+/**
+ * Render detailed information for a single course
+ * @param out Buffer to render into
+ * @param course Course to render
+ */
+void renderCourse(OutputBuffer& out, const Course& course)
+{
+    out.append(course.courseNumber).append(", ", 2).append(course.name).append('\n');
+    
+    if (course.prerequisites.size() == 0 && course.corequisiteGroups.empty()) {
+        out.append("No prerequisites\n\n", 18);
+        return;
+    }
+    
+    if (course.prerequisites.size() > 0) {
+        out.append("Prerequisites: ", 15);
+        if (course.prerequisiteGroups.empty()) {
+            // Ungrouped prerequisites are each their own group
+            for (size_t i = 0; i < course.prerequisites.size(); ++i) {
+                if (i > 0) out.append(", ", 2);
+                out.append(course.prerequisites[i]);
+            }
+        } else {
+            renderRequirementGroups(out, course.prerequisiteGroups);
+        }
+        out.append('\n');
+    }
+    
+    if (!course.corequisiteGroups.empty()) {
+        out.append("Corequisites: ", 14);
+        renderRequirementGroups(out, course.corequisiteGroups);
+        out.append('\n');
+    }
+    out.append('\n');
+}
+
+
+/**
+ * Print detailed information for a single course
+ * @param course Course object to print
+ */
+void printCourse(const Course& course)
+{
+    OutputBuffer out(STDOUT_FILENO);
+    renderCourse(out, course);
+}
+
+
+/**
+ * Print all courses in catalog order (previously sorted in loadCoursesFile)
+ *
+ * The whole list is rendered through one output buffer, so a large catalog costs
+ * one write per buffer-full rather than a flush per line, and large catalogs are
+ * formatted in parallel slices.
+ *
+ * @param courses Sorted view of the courses to print
+ */
+void printCourseList(const CourseOrdering& courses)
+{
+    if (courses.empty()) {
+        cout << "No courses loaded. Please load data first.\n" << endl;
+        return;
+    }
+    
+    OutputBuffer out(STDOUT_FILENO);
+    renderParallel(out, courses.size(), [&](OutputBuffer& slice, size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++)
+        {
+            renderCourse(slice, courses[i]);
+        }
+    });
+}
+
+/**
+ * Render a course as text, exactly as printCourse prints it
+ * @param course Course to render
+ */
+void CourseSerializer::renderText(const Course& course)
+{
+    renderCourse(out, course);
+}
+
+
+/**
+ * Parse an output format name
+ * @param name "text", "json", "ndjson" or "csv"
+ * @param format Set to the parsed format
+ * @return false if the name is unknown
+ */
+bool parseOutputFormat(const string& name, OutputFormat& format)
+{
+    string key = toLowerCase(name);
+    if (key == "text") format = OutputFormat::Text;
+    else if (key == "json") format = OutputFormat::Json;
+    else if (key == "ndjson") format = OutputFormat::Ndjson;
+    else if (key == "csv") format = OutputFormat::Csv;
+    else return false;
+    return true;
+}
+
+
+/**
+ * State carried between the commands of one batch session
+ */
+struct CommandSession
+{
+    OutputFormat format = OutputFormat::Text; // Format of every response
+    bool finished = false; // Flag set by the quit command
+    vector<tuple<size_t, size_t, uint64_t>> unsyncedEdits; // Buffer offsets and sequence number of edit
+                                                           // responses not yet known to be logged
+    size_t lostEdits = 0; // Edits answered as logged, then undone because the log could not be written
+};
+
+
+/**
+ * Write queued edits to the edit log before their responses leave the buffer
+ *
+ * If the log cannot be written, the catalog is reloaded from its courses file
+ * and the part of the log that did reach the disk, undoing the rest, and each
+ * response to an undone edit still in the buffer is replaced by an error record.
+ * The buffer must not have been written out since the responses were added.
+ *
+ * @param session Session whose edit responses are in the buffer
+ * @param out Buffer holding the responses
+ * @param error Output: why the log could not be written
+ * @return false if edits were undone
+ */
+bool syncEditLog(CommandSession& session, OutputBuffer& out, string& error)
+{
+    if (catalogLog.sync()) {
+        session.unsyncedEdits.clear();
+        return true;
+    }
+    error = catalogLog.error();
+    uint64_t durable = catalogLog.durableSequence();
+    string path = catalogLog.coursesPath();
+    
+    // Rewrite the buffer from the first undone response onwards
+    auto firstLost = find_if(session.unsyncedEdits.begin(), session.unsyncedEdits.end(),
+                             [&](const tuple<size_t, size_t, uint64_t>& edit) { return get<2>(edit) > durable; });
+    if (firstLost != session.unsyncedEdits.end()) {
+        size_t start = get<0>(*firstLost);
+        string tail(out.data() + start, out.size() - start);
+        out.truncate(start);
+        size_t copied = start;
+        for (auto edit = firstLost; edit != session.unsyncedEdits.end(); ++edit) {
+            out.append(tail.data() + (copied - start), get<0>(*edit) - copied);
+            CourseSerializer::writeError(out, session.format, "could not write edit log, so edit " +
+                                         to_string(get<2>(*edit)) + " was undone: " + error);
+            copied = get<1>(*edit);
+            session.lostEdits++;
+        }
+        out.append(tail.data() + (copied - start), tail.size() - (copied - start));
+    }
+    session.unsyncedEdits.clear();
+    
+    // The catalog in memory has edits the log lacks, so load it again from disk
+    if (!path.empty()) {
+        ostringstream messages;
+        loadCatalog(path, messages);
+    }
+    return false;
+}
+
+
+/**
+ * Parse a catalog ordering name
+ * @param name "name", "department", "level" or "prerequisites"
+ * @param order Set to the parsed ordering
+ * @return false if the name is unknown
+ */
+bool parseCatalogOrder(const string& name, CatalogOrder& order)
+{
+    string key = toLowerCase(name);
+    if (key == "name") order = CatalogOrder::Name;
+    else if (key == "department") order = CatalogOrder::Department;
+    else if (key == "level") order = CatalogOrder::Level;
+    else if (key == "prerequisites") order = CatalogOrder::PrerequisiteCount;
+    else return false;
+    return true;
+}
+
+
+/**
+ * Parse a non-negative count argument
+ * @param text Argument text
+ * @param value Set to the parsed count
+ * @return false unless text is all digits
+ */
+bool parseCount(const string& text, size_t& value)
+{
+    if (text.empty() || text.size() > 18 || text.find_first_not_of("0123456789") != string::npos) return false;
+    value = stoull(text);
+    return true;
+}
+
+
+/**
+ * Execute one batch command against the loaded catalog
+ *
+ * Commands, one per line, with arguments separated by whitespace:
+ * - load [path]: load a courses file (courses.txt by default)
+ * - attach <name>: query a catalog image published by another process instead
+ * - format <text|json|ndjson|csv>: set the format of later responses
+ * - lookup <course>: one course ("course" is accepted too)
+ * - list [order] [offset] [limit]: courses by name, department (the default),
+ *   level or prerequisites, optionally one page of them
+ * - dependents <course> [hops], ancestors <course> [hops]: courses reached through
+ *   the prerequisite graph, nearest first, with their hop distance
+ * - eligible <course>...: courses that may be taken after completing the given
+ *   courses; a course prefixed with '+' is being taken this semester instead
+ * - level <course>: the earliest semester a course can be taken
+ * - plan [course]: a course and all its prerequisites, or the whole catalog, in
+ *   an order they can be taken, with their levels; undefined prerequisites are left out
+ * - impact <course>: the number of courses blocked if a course is cancelled
+ * - critical [limit]: courses ranked by how many courses they block
+ * - search <text>: courses whose number or name contains the text, ignoring case
+ * - transcripts <path>: load student transcripts from a CSV file of
+ *   student,course,term,grade[,credits] rows
+ * - audit <rules file> [student]...: check the given students, or every student,
+ *   against a file of degree rules (see DegreeAudit::parseRules)
+ * - add <course line>: add or replace a course, given as a line of the courses file
+ * - remove <course>: remove a course that no other course requires
+ * - require <course> <prerequisite>, unrequire <course> <prerequisite>: add or
+ *   remove a prerequisite of a course
+ * - compact: fold the edit log into the courses file
+ * - version <term> <path>: keep a courses file as the catalog from a term onwards
+ * - asof <term> lookup <course>, asof <term> eligible <course>...: lookup and
+ *   eligible against the catalog in effect for a term
+ * - quit: stop reading commands
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * Every command writes one response, which is an error record if it fails.
+ * Edits to a loaded catalog are logged beside its courses file and replayed when
+ * it is next loaded. They are acknowledged once logged: queued edits are synced
+ * together (see syncEditLog) before any other command runs, before a response
+ * could fill the output buffer, and by runBatch before it writes responses out.
+ * If the sync fails, the edits are undone and their responses become errors.
+ *
+ * Commands that walk the graph or the whole catalog spend a YieldBudget as they
+ * go, so on a CoroutineScheduler they pause between hops and every thousand or so
+ * courses to let quick queries run. The catalog must not change while a query is
+ * paused, so concurrent queries need a catalog that is not being edited.
+ *
+ * @param line Command line
+ * @param session Batch session state
+ * @param out Buffer the response is written to
+ * @param scheduler Scheduler running the query, or null to run it without pausing
+ * @return false if the command failed
+ */
+Task<bool> executeQuery(const string& line, CommandSession& session, OutputBuffer& out, CoroutineScheduler* scheduler)
+{
+    vector<string> args;
+    size_t start = line.find_first_not_of(" \t\r");
+    while (start != string::npos) {
+        size_t end = line.find_first_of(" \t\r", start);
+        args.push_back(line.substr(start, end - start));
+        start = line.find_first_not_of(" \t\r", end);
+    }
+    if (args.empty() || args[0][0] == '#') {
+        co_return true;
+    }
+    
+    // "course" is the name --export gave lookup before batch mode
+    const string command = (toLowerCase(args[0]) == "course") ? "lookup" : toLowerCase(args[0]);
+    const OutputFormat format = session.format;
+    YieldBudget budget(scheduler);
+    auto fail = [&](const string& message) {
+        CourseSerializer::writeError(out, format, message);
+        return false;
+    };
+    
+    // Edits are acknowledged only once logged, so edits waiting for group commit are
+    // written before any other command runs, or an edit's output could fill the
+    // buffer and flush their responses (an error quotes at most the line, escaped)
+    const bool edit = command == "add" || command == "remove" || command == "require" || command == "unrequire";
+    if (!session.unsyncedEdits.empty() && (!edit || out.size() + 6 * line.size() + 256 > out.capacity())) {
+        string error;
+        syncEditLog(session, out, error);
+    }
+    
+    if (command == "quit") {
+        session.finished = true;
+        co_return true;
+    }
+    if (command == "format") {
+        if (args.size() != 2 || !parseOutputFormat(args[1], session.format)) {
+            co_return fail("usage: format <text|json|ndjson|csv>");
+        }
+        co_return true;
+    }
+    if (command == "load") {
+        size_t pathStart = line.find_first_not_of(" \t", line.find(args[0]) + args[0].size());
+        string path = (pathStart == string::npos) ? "courses.txt" : line.substr(pathStart);
+        path.erase(path.find_last_not_of(" \t\r") + 1);
+        
+        ostringstream messages;
+        loadCatalog(path, messages);
+        if (!dataLoaded) {
+            string message = messages.str();
+            co_return fail(message.substr(0, message.find('\n')));
+        }
+        CourseSerializer::writeCount(out, format, "loaded", courseHashTable.size());
+        co_return true;
+    }
+    if (command == "attach") {
+        if (args.size() != 2) {
+            co_return fail("usage: attach <name>");
+        }
+        ostringstream messages;
+        if (!attachCatalogImage(args[1], messages)) {
+            string message = messages.str();
+            co_return fail(message.substr(0, message.find('\n')));
+        }
+        CourseSerializer::writeCount(out, format, "attached", catalogImage.size());
+        co_return true;
+    }
+    if (command == "transcripts") {
+        size_t pathStart = line.find_first_not_of(" \t", line.find(args[0]) + args[0].size());
+        string path = (pathStart == string::npos) ? "" : line.substr(pathStart);
+        path.erase(path.find_last_not_of(" \t\r") + 1);
+        if (path.empty()) {
+            co_return fail("usage: transcripts <path>");
+        }
+        
+        ifstream file(path);
+        if (!file.is_open()) {
+            co_return fail("could not open " + path);
+        }
+        string error;
+        if (!transcriptStore.read(file, error)) {
+            co_return fail(path + ": " + error);
+        }
+        CourseSerializer::writeCount(out, format, "rows", transcriptStore.rowCount());
+        co_return true;
+    }
+    
+    if (command == "version") {
+        if (args.size() != 3) {
+            co_return fail("usage: version <term> <path>");
+        }
+        ifstream file(args[2]);
+        if (!file.is_open()) {
+            co_return fail("could not open " + args[2]);
+        }
+        vector<Course> courses;
+        string courseLine;
+        while (getline(file, courseLine) && courseLine != "-1") {
+            if (courseLine.empty()) continue;
+            Course course = parseCourseLine(courseLine);
+            if (course.courseNumber.empty()) {
+                co_return fail(args[2] + " has an invalid course line: " + courseLine);
+            }
+            courses.push_back(course);
+        }
+        if (courses.empty()) {
+            co_return fail(args[2] + " has no courses");
+        }
+        CatalogVersions::CommitStats stats = catalogVersions.commit(args[1], courses);
+        CourseSerializer::writeCount(out, format, "changed", stats.added + stats.changed + stats.removed);
+        co_return true;
+    }
+    if (command == "asof") {
+        const string query = (args.size() > 2) ? toLowerCase(args[2]) : "";
+        if ((query != "lookup" || args.size() != 4) && query != "eligible") {
+            co_return fail("usage: asof <term> lookup <course> | asof <term> eligible <course>...");
+        }
+        if (!catalogVersions.hasTerm(args[1])) {
+            co_return fail("no catalog for term " + args[1]);
+        }
+        if (query == "lookup") {
+            const Course* found = catalogVersions.find(args[1], args[3]);
+            if (!found) {
+                co_return fail("unknown course " + args[3] + " in term " + args[1]);
+            }
+            CourseSerializer serializer(out, format, CourseSerializer::Records::Courses, false);
+            serializer.write(*found);
+            serializer.finish();
+            co_return true;
+        }
+        
+        vector<string> completed, enrolled;
+        for (size_t i = 3; i < args.size(); i++) {
+            if (args[i][0] == '+') enrolled.push_back(args[i].substr(1));
+            else completed.push_back(args[i]);
+        }
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Courses);
+        for (const Course* eligible : catalogVersions.findEligibleCourses(args[1], completed, enrolled)) {
+            serializer.write(*eligible);
+            co_await budget.spend();
+        }
+        serializer.finish();
+        co_return true;
+    }
+    
+    if (!dataLoaded) {
+        co_return fail("no courses loaded");
+    }
+    // Queries read the attached image instead of the loaded catalog when there is one
+    const bool attached = catalogImage.isAttached();
+    
+    if (edit || command == "compact") {
+        if (attached) {
+            co_return fail("an attached catalog cannot be edited");
+        }
+        string logError = catalogLog.error();
+        if (!logError.empty()) {
+            co_return fail("edits cannot be logged: " + logError);
+        }
+    }
+    if (command == "compact") {
+        if (args.size() != 1) {
+            co_return fail("usage: compact");
+        }
+        catalogLog.waitForCompaction();
+        catalogLog.startCompaction(formatCatalogSnapshot());
+        string error = catalogLog.waitForCompaction();
+        if (error.empty()) error = catalogLog.error();
+        if (!error.empty()) {
+            co_return fail("could not compact edit log: " + error);
+        }
+        CourseSerializer::writeCount(out, format, "compacted", courseHashTable.size());
+        co_return true;
+    }
+    if (edit) {
+        CatalogLog::Edit logged;
+        if (command == "add") {
+            size_t textStart = line.find_first_not_of(" \t", line.find(args[0]) + args[0].size());
+            string text = (textStart == string::npos) ? "" : line.substr(textStart);
+            text.erase(text.find_last_not_of(" \t\r") + 1);
+            Course course = parseCourseLine(text);
+            if (course.courseNumber.empty()) {
+                co_return fail("usage: add <course>,<name>[,<prerequisite group>]...");
+            }
+            if (!addCatalogCourse(course)) {
+                co_return fail(course.courseNumber + " would create a prerequisite cycle");
+            }
+            logged = {CatalogLog::Op::AddCourse, {text}};
+        } else if (command == "remove") {
+            if (args.size() != 2) {
+                co_return fail("usage: remove <course>");
+            }
+            if (!courseHashTable.find(args[1])) {
+                co_return fail("unknown course " + args[1]);
+            }
+            // Removing a required course would leave its dependents with an undefined prerequisite
+            list<string> dependents = prereqGraph.getDependents(args[1]);
+            if (!dependents.empty()) {
+                const Course* dependent = courseHashTable.find(dependents.front());
+                string others = (dependents.size() > 1) ? " and " + to_string(dependents.size() - 1) + " other course(s)" : "";
+                co_return fail(args[1] + " is still required by " + (dependent ? dependent->courseNumber : dependents.front()) + others);
+            }
+            if (!removeCatalogCourse(args[1])) {
+                co_return fail("unknown course " + args[1]);
+            }
+            logged = {CatalogLog::Op::RemoveCourse, {args[1]}};
+        } else {
+            if (args.size() != 3) {
+                co_return fail("usage: " + command + " <course> <prerequisite>");
+            }
+            if (command == "require" && !addCatalogPrerequisite(args[1], args[2])) {
+                co_return fail(args[1] + " is unknown or would create a prerequisite cycle");
+            }
+            if (command == "unrequire" && !removeCatalogPrerequisite(args[1], args[2])) {
+                co_return fail(args[1] + " does not require " + args[2]);
+            }
+            logged = {command == "require" ? CatalogLog::Op::AddPrerequisite : CatalogLog::Op::RemovePrerequisite,
+                      {args[1], args[2]}};
+        }
+        
+        // Group commit: the edit is written with the others queued before its
+        // response leaves the buffer, and the log compacted once it is long
+        uint64_t sequence = catalogLog.append(logged);
+        if (catalogLog.wantsCompaction()) {
+            catalogLog.startCompaction(formatCatalogSnapshot());
+        }
+        // A nearly full buffer holds no unsynced responses (see above), so it can be written out
+        // first, and this response's place in the buffer stays known until the next sync
+        if (out.size() + 256 > out.capacity()) out.flush();
+        size_t responseStart = out.size();
+        CourseSerializer::writeCount(out, format, "logged", sequence);
+        session.unsyncedEdits.emplace_back(responseStart, out.size(), sequence);
+        co_return true;
+    }
+    
+    if (command == "list") {
+        CatalogOrder order = CatalogOrder::Department;
+        size_t offset = 0, limit = SIZE_MAX;
+        if ((args.size() > 1 && !parseCatalogOrder(args[1], order)) ||
+            (args.size() > 2 && !parseCount(args[2], offset)) ||
+            (args.size() > 3 && !parseCount(args[3], limit)) || args.size() > 4) {
+            co_return fail("usage: list [name|department|level|prerequisites] [offset] [limit]");
+        }
+        
+        CourseOrdering courses;
+        span<const uint32_t> imageIds;
+        if (attached) {
+            span<const uint32_t> all = catalogImage.ordering(order);
+            size_t first = min(offset, all.size());
+            imageIds = all.subspan(first, min(limit, all.size() - first));
+        } else {
+            courses = getCatalogPage(order, offset, limit);
+        }
+        const size_t count = attached ? imageIds.size() : courses.size();
+        
+        // Rendered a block at a time, pausing between blocks; within a block, the slice
+        // starting at record 0 writes the opening, and the last slice the closing
+        const size_t BLOCK = 16 * YieldBudget::DEFAULT_INTERVAL;
+        size_t blockStart = 0;
+        do {
+            size_t blockEnd = min(count, blockStart + BLOCK);
+            renderParallel(out, blockEnd - blockStart, [&](OutputBuffer& slice, size_t begin, size_t end) {
+                begin += blockStart;
+                end += blockStart;
+                CourseSerializer serializer(slice, format, CourseSerializer::Records::Courses, true, begin);
+                for (size_t i = begin; i < end; i++) {
+                    if (attached) serializer.write(catalogImage.course(imageIds[i]));
+                    else serializer.write(courses[i]);
+                }
+                if (end == count) serializer.finish();
+            });
+            co_await budget.spend(blockEnd - blockStart);
+            blockStart = blockEnd;
+        } while (blockStart < count);
+        co_return true;
+    }
+    if (command == "eligible") {
+        vector<string> completed, enrolled;
+        for (size_t i = 1; i < args.size(); i++) {
+            if (args[i][0] == '+') enrolled.push_back(args[i].substr(1));
+            else completed.push_back(args[i]);
+        }
+        CourseBitset completedSet = attached ? catalogImage.makeCourseSet(completed) : prereqGraph.makeCourseSet(completed);
+        CourseBitset enrolledSet = attached ? catalogImage.makeCourseSet(enrolled) : prereqGraph.makeCourseSet(enrolled);
+        
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Courses);
+        const size_t BLOCK = 4 * YieldBudget::DEFAULT_INTERVAL;
+        const size_t idCount = attached ? catalogImage.courseCount() : prereqGraph.courseCount();
+        for (size_t firstId = 0; firstId < idCount; firstId += BLOCK) {
+            if (attached) {
+                for (size_t id = firstId; id < min(idCount, firstId + BLOCK); id++) {
+                    if (catalogImage.isEligible((int)id, completedSet, &enrolledSet)) {
+                        serializer.write(catalogImage.course((int)id));
+                    }
+                }
+            } else {
+                for (const string& courseNumber : prereqGraph.findEligibleCourses(completedSet, &enrolledSet, firstId, firstId + BLOCK)) {
+                    const Course* course = courseHashTable.find(courseNumber);
+                    if (course) serializer.write(*course);
+                }
+            }
+            co_await budget.spend(BLOCK);
+        }
+        serializer.finish();
+        co_return true;
+    }
+    if (command == "search") {
+        size_t textStart = line.find(args[0]) + args[0].size();
+        string text = (args.size() > 1) ? toLowerCase(line.substr(line.find(args[1], textStart))) : "";
+        text.erase(text.find_last_not_of(" \t\r") + 1);
+        if (text.empty()) {
+            co_return fail("usage: search <text>");
+        }
+        
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Courses);
+        if (attached) {
+            for (uint32_t id : catalogImage.ordering(CatalogOrder::Department)) {
+                if (toLowerCase(catalogImage.courseNumber(id)).find(text) != string::npos ||
+                    toLowerCase(catalogImage.name(id)).find(text) != string::npos) {
+                    serializer.write(catalogImage.course(id));
+                }
+                co_await budget.spend();
+            }
+            serializer.finish();
+            co_return true;
+        }
+        
+        CourseOrdering courses = getCatalogOrdering(CatalogOrder::Department);
+        for (size_t i = 0; i < courses.size(); i++) {
+            const Course& course = courses[i];
+            if (toLowerCase(course.courseNumber).find(text) != string::npos ||
+                toLowerCase(course.name).find(text) != string::npos) {
+                serializer.write(course);
+            }
+            co_await budget.spend();
+        }
+        serializer.finish();
+        co_return true;
+    }
+    if (command == "critical") {
+        size_t limit = 0;
+        if (args.size() > 2 || (args.size() == 2 && !parseCount(args[1], limit))) {
+            co_return fail("usage: critical [limit]");
+        }
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Blocked);
+        if (attached) {
+            span<const uint32_t> ranking = catalogImage.criticalOrder();
+            for (size_t i = 0; i < ranking.size() && (limit == 0 || i < limit); i++) {
+                serializer.write(catalogImage.courseNumber(ranking[i]), catalogImage.name(ranking[i]),
+                                 catalogImage.descendantCount(ranking[i]));
+                co_await budget.spend();
+            }
+            serializer.finish();
+            co_return true;
+        }
+        for (const pair<string, int>& ranked : prereqGraph.rankByCriticality(limit)) {
+            const Course* course = courseHashTable.find(ranked.first);
+            serializer.write(course ? course->courseNumber : ranked.first, course ? course->name : "", ranked.second);
+            co_await budget.spend();
+        }
+        serializer.finish();
+        co_return true;
+    }
+    if (command == "audit") {
+        if (args.size() < 2) {
+            co_return fail("usage: audit <rules file> [student]...");
+        }
+        if (transcriptStore.studentCount() == 0) {
+            co_return fail("no transcripts loaded");
+        }
+        ifstream file(args[1]);
+        if (!file.is_open()) {
+            co_return fail("could not open " + args[1]);
+        }
+        vector<AuditRule> rules;
+        string error;
+        if (!DegreeAudit::parseRules(file, rules, error)) {
+            co_return fail(args[1] + ": " + error);
+        }
+        
+        vector<uint32_t> students;
+        for (size_t i = 2; i < args.size(); i++) {
+            long student = transcriptStore.findStudent(args[i]);
+            if (student < 0) {
+                co_return fail("unknown student " + args[i]);
+            }
+            students.push_back((uint32_t)student);
+        }
+        const size_t count = (args.size() > 2) ? students.size() : transcriptStore.studentCount();
+        
+        function<int(const string&)> catalogId;
+        if (attached) catalogId = [](const string& courseNumber) { return catalogImage.find(courseNumber); };
+        else catalogId = [](const string& courseNumber) { return prereqGraph.getCourseId(courseNumber); };
+        const DegreeAudit engine(transcriptStore, move(rules), catalogId,
+                                 attached ? catalogImage.requirementPrograms() : prereqGraph.requirementPrograms());
+        
+        // Audited a block at a time like list, each slice with its own scratch memory
+        const size_t BLOCK = 16 * YieldBudget::DEFAULT_INTERVAL;
+        size_t blockStart = 0;
+        do {
+            size_t blockEnd = min(count, blockStart + BLOCK);
+            renderParallel(out, blockEnd - blockStart, [&](OutputBuffer& slice, size_t begin, size_t end) {
+                begin += blockStart;
+                end += blockStart;
+                DegreeAudit::Scratch scratch(engine);
+                vector<string> unmet;
+                CourseSerializer serializer(slice, format, CourseSerializer::Records::Audits, true, begin);
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t student = students.empty() ? (uint32_t)i : students[i];
+                    engine.audit(student, scratch, unmet);
+                    serializer.write(transcriptStore.studentName(student), unmet);
+                }
+                if (end == count) serializer.finish();
+            });
+            co_await budget.spend(blockEnd - blockStart);
+            blockStart = blockEnd;
+        } while (blockStart < count);
+        co_return true;
+    }
+    if (command == "plan" && args.size() == 1) {
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Levels);
+        if (attached) {
+            for (uint32_t id : catalogImage.topologicalOrder()) {
+                if (!catalogImage.isDefined(id)) continue;
+                serializer.write(catalogImage.courseNumber(id), catalogImage.name(id), catalogImage.level(id));
+                co_await budget.spend();
+            }
+            serializer.finish();
+            co_return true;
+        }
+        // Prerequisites that were never defined (or were removed) cannot be planned
+        for (const string& courseNumber : prereqGraph.getTopologicalOrder()) {
+            const Course* course = courseHashTable.find(courseNumber);
+            if (!course) continue;
+            serializer.write(course->courseNumber, course->name, prereqGraph.getCourseLevel(courseNumber));
+            co_await budget.spend();
+        }
+        serializer.finish();
+        co_return true;
+    }
+    
+    // The remaining commands start from one course
+    if (command != "lookup" && command != "dependents" && command != "ancestors" &&
+        command != "level" && command != "plan" && command != "impact") {
+        co_return fail("unknown command " + args[0]);
+    }
+    if (args.size() < 2) {
+        co_return fail("usage: " + command + " <course>");
+    }
+    const Course* course = nullptr;
+    Course attachedCourse;
+    int courseId = -1;
+    if (attached) {
+        courseId = catalogImage.find(args[1]);
+        if (courseId >= 0 && catalogImage.isDefined(courseId)) {
+            attachedCourse = catalogImage.course(courseId);
+            course = &attachedCourse;
+        }
+    } else {
+        course = courseHashTable.find(args[1]);
+    }
+    if (!course) {
+        co_return fail("unknown course " + args[1]);
+    }
+    
+    if (command == "lookup") {
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Courses, false);
+        serializer.write(*course);
+        serializer.finish();
+    } else if (command == "dependents" || command == "ancestors") {
+        size_t hops = 0;
+        if (args.size() > 3 || (args.size() == 3 && !parseCount(args[2], hops))) {
+            co_return fail("usage: " + command + " <course> [hops]");
+        }
+        TraversalDirection direction = (command == "dependents") ? TraversalDirection::Dependents : TraversalDirection::Ancestors;
+        
+        int maxHops = (args.size() == 3) ? (int)hops : -1;
+        PrerequisiteGraph::HopSearch search = attached ? catalogImage.startHopSearch(courseId, direction, maxHops)
+                                                       : prereqGraph.startHopSearch(course->courseNumber, direction, maxHops);
+        while (search.step()) {
+            co_await budget.spend(search.frontierSize());
+        }
+        
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Reached);
+        if (attached) {
+            for (const pair<int, int>& reached : search.resultIds()) {
+                serializer.write(catalogImage.courseNumber(reached.first), catalogImage.name(reached.first), reached.second);
+                co_await budget.spend();
+            }
+        } else {
+            for (const pair<string, int>& reached : search.results()) {
+                const Course* found = courseHashTable.find(reached.first);
+                serializer.write(found ? found->courseNumber : reached.first, found ? found->name : "", reached.second);
+                co_await budget.spend();
+            }
+        }
+        serializer.finish();
+    } else if (command == "level") {
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Levels, false);
+        serializer.write(course->courseNumber, course->name,
+                         attached ? catalogImage.level(courseId) : prereqGraph.getCourseLevel(course->courseNumber));
+        serializer.finish();
+    } else if (command == "impact") {
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Blocked, false);
+        serializer.write(course->courseNumber, course->name,
+                         attached ? catalogImage.descendantCount(courseId) : prereqGraph.getDescendantCount(course->courseNumber));
+        serializer.finish();
+    } else if (attached) {
+        // Plan: the course's prerequisites by level, then the course itself
+        PrerequisiteGraph::HopSearch search = catalogImage.startHopSearch(courseId, TraversalDirection::Ancestors);
+        while (search.step()) {
+            co_await budget.spend(search.frontierSize());
+        }
+        
+        vector<pair<int, int>> planned;
+        for (const pair<int, int>& ancestor : search.resultIds()) {
+            if (!catalogImage.isDefined(ancestor.first)) continue;
+            planned.emplace_back(catalogImage.level(ancestor.first), ancestor.first);
+        }
+        stable_sort(planned.begin(), planned.end(), [](const pair<int, int>& a, const pair<int, int>& b) {
+            return a.first < b.first;
+        });
+        planned.emplace_back(catalogImage.level(courseId), courseId);
+        
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Levels);
+        for (const pair<int, int>& step : planned) {
+            serializer.write(catalogImage.courseNumber(step.second), catalogImage.name(step.second), step.first);
+            co_await budget.spend();
+        }
+        serializer.finish();
+    } else {
+        // Plan: the course's prerequisites by level, then the course itself
+        PrerequisiteGraph::HopSearch search = prereqGraph.startHopSearch(course->courseNumber, TraversalDirection::Ancestors);
+        while (search.step()) {
+            co_await budget.spend(search.frontierSize());
+        }
+        
+        vector<pair<int, string>> planned;
+        for (const pair<string, int>& ancestor : search.results()) {
+            planned.emplace_back(prereqGraph.getCourseLevel(ancestor.first), ancestor.first);
+        }
+        stable_sort(planned.begin(), planned.end(), [](const pair<int, string>& a, const pair<int, string>& b) {
+            return a.first < b.first;
+        });
+        planned.emplace_back(prereqGraph.getCourseLevel(course->courseNumber), course->courseNumber);
+        
+        // Prerequisites that were never defined (or were removed) cannot be planned
+        CourseSerializer serializer(out, format, CourseSerializer::Records::Levels);
+        for (const pair<int, string>& step : planned) {
+            const Course* found = courseHashTable.find(step.second);
+            if (!found) continue;
+            serializer.write(found->courseNumber, found->name, step.first);
+            co_await budget.spend();
+        }
+        serializer.finish();
+    }
+    co_return true;
+}
+
+
+/**
+ * Execute one batch command against the loaded catalog, on the calling thread
+ * @param line Command line (see executeQuery)
+ * @param session Batch session state
+ * @param out Buffer the response is written to
+ * @return false if the command failed
+ */
+bool executeCommand(const string& line, CommandSession& session, OutputBuffer& out)
+{
+    return syncWait(executeQuery(line, session, out, nullptr));
+}
+
+
+/**
+ * Run batch commands until end of input or quit
+ *
+ * Responses are buffered and written whenever no further input is already
+ * waiting, so a file of commands is answered in large writes while a program
+ * feeding commands through a pipe still sees each response before it sends the
+ * next command. Edits are synced to the edit log just before each write, so a
+ * run of edits read together is committed as one group.
+ *
+ * @param in Stream of commands
+ * @return Number of commands that failed
+ */
+size_t runBatch(istream& in)
+{
+    CommandSession session;
+    OutputBuffer out(STDOUT_FILENO);
+    size_t failures = 0;
+    string line;
+    
+    string error;
+    while (!session.finished && getline(in, line)) {
+        if (!executeCommand(line, session, out)) {
+            failures++;
+        }
+        if (in.rdbuf()->in_avail() <= 0) {
+            syncEditLog(session, out, error);
+            out.flush();
+        }
+    }
+    syncEditLog(session, out, error);
+    return failures + session.lostEdits;
+}
+
+
+/**
+ * Build every lazily computed catalog structure before queries run concurrently
+ *
+ * Query commands only read the catalog once its indexes, levels, traversal
+ * arrays, descendant counts and compiled requirements exist, so warming them
+ * first lets worker threads share one catalog without locking.
+ */
+void warmCatalogCaches()
+{
+    CourseOrdering courses = getCatalogOrdering(CatalogOrder::Department);
+    if (courses.empty()) return;
+    
+    const string& courseNumber = courses[0].courseNumber;
+    prereqGraph.getCourseLevel(courseNumber);
+    prereqGraph.countWithinHops(courseNumber, TraversalDirection::Dependents);
+    prereqGraph.getDescendantCount(courseNumber);
+    prereqGraph.findEligibleCourses(prereqGraph.makeCourseSet(vector<string>()));
+}
+
+
+/**
+ * Query Server
+ *
+ * Serves batch commands against one resident catalog over a Unix domain socket
+ * or a localhost TCP port. A single thread runs an epoll loop that accepts
+ * connections, reads requests and writes responses without blocking; commands
+ * run as coroutines on a CoroutineScheduler, and each finished response is handed
+ * back to the loop through an eventfd. Long queries pause every thousand or so
+ * courses, so lookups from other connections are not stuck behind them.
+ *
+ * Two protocols are accepted on the same socket, chosen by each connection's
+ * first bytes:
+ * - Lines: exactly the --batch protocol, one command per line, with the
+ *   connection keeping its own output format.
+ * - HTTP/1.1 GET: the path segments form the command and ?format= sets its
+ *   format (JSON by default), so GET /dependents/CSCI101?format=csv runs
+ *   "dependents CSCI101". Responses carry a Content-Length, and connections are
+ *   kept alive unless the client asks otherwise.
+ *
+ * Each connection has at most one batch of requests executing at a time, so its
+ * responses come back in request order. The catalog is read-only while serving:
+ * load and attach are refused.
+ */
+class QueryServer {
+private:
+    static constexpr size_t MAX_REQUEST = 1 << 20; // Longest request line or HTTP head accepted
+    static constexpr size_t MAX_LINES_PER_TASK = 256; // Pipelined lines executed in one task
+    
+    /**
+     * One client connection
+     */
+    struct Connection {
+        string input; // Received bytes not yet executed
+        string output; // Response bytes not yet sent
+        size_t sent = 0; // Bytes of output already sent
+        bool busy = false; // Flag set while a coroutine executes this connection's requests
+        bool closing = false; // Flag set once no further requests will be read
+        bool http = false; // Flag set if the connection speaks HTTP
+        bool registered = true; // Flag cleared once the socket is removed from epoll after a hang-up
+        uint32_t events = EPOLLIN | EPOLLRDHUP; // Events currently watched
+        CommandSession session; // Output format for the line protocol
+    };
+    
+    /**
+     * A response finished by a worker
+     */
+    struct Completion {
+        int fd; // Connection the response belongs to
+        string response; // Bytes to send
+        CommandSession session; // Session state after the requests
+        bool close; // Flag set if the connection should close after the response
+    };
+    
+    /**
+     * Block SIGINT and SIGTERM in the calling thread so they are read from a signalfd instead;
+     * threads started afterwards, including the scheduler's workers, inherit the mask
+     * @return The blocked signals
+     */
+    static sigset_t blockShutdownSignals() {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        return signals;
+    }
+    
+    sigset_t shutdownSignals = blockShutdownSignals(); // Must be initialized before the scheduler starts its threads
+    CoroutineScheduler scheduler;
+    int epollFd = -1;
+    int listenFd = -1;
+    int wakeFd = -1; // eventfd signalled when completions are queued
+    int signalFd = -1; // SIGINT and SIGTERM, for a clean shutdown
+    string socketPath; // Unix socket to remove at shutdown, if any
+    unordered_map<int, Connection> connections;
+    mutex completedLock;
+    vector<Completion> completed;
+    atomic<size_t> requestsServed{0};
+    
+    /**
+     * Register or update the events watched for a file descriptor
+     */
+    void watch(int fd, uint32_t events, bool add) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
+    }
+    
+    /**
+     * Watch a connection for reads until it is closing, and for writes while output is pending
+     * @param fd Connection to update
+     */
+    void updateEvents(int fd) {
+        Connection& connection = connections[fd];
+        uint32_t events = (connection.closing ? 0 : EPOLLIN | EPOLLRDHUP) |
+                          (connection.sent < connection.output.size() ? (uint32_t)EPOLLOUT : 0u);
+        if (connection.registered && events != connection.events) {
+            connection.events = events;
+            watch(fd, events, false);
+        }
+    }
+    
+    static void setNonBlocking(int fd) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    
+    /**
+     * Decode %XX escapes and '+' in one URL component
+     */
+    static string urlDecode(const string& text) {
+        string decoded;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '+') {
+                decoded += ' ';
+            } else if (text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) &&
+                       isxdigit((unsigned char)text[i + 2])) {
+                decoded += (char)stoi(text.substr(i + 1, 2), nullptr, 16);
+                i += 2;
+            } else {
+                decoded += text[i];
+            }
+        }
+        return decoded;
+    }
+    
+    /**
+     * Execute pipelined line-protocol commands and hand their responses to the event loop
+     * @param fd Connection the commands came from
+     * @param lines Commands in order
+     * @param session Session state, updated by format commands
+     */
+    Task<void> serveLines(int fd, vector<string> lines, CommandSession session) {
+        Completion done = {fd, string(), CommandSession(), false};
+        OutputBuffer out(-1);
+        for (const string& line : lines) {
+            co_await runCommand(line, session, out);
+            requestsServed++;
+            if (session.finished) {
+                done.close = true;
+                break;
+            }
+        }
+        done.response.assign(out.data(), out.size());
+        done.session = session;
+        complete(move(done));
+    }
+    
+    /**
+     * Execute one command, refusing the ones that would change the shared catalog or transcripts
+     * @return false if the command failed
+     */
+    Task<bool> runCommand(const string& line, CommandSession& session, OutputBuffer& out) {
+        size_t start = line.find_first_not_of(" \t\r");
+        string command = (start == string::npos) ? "" : toLowerCase(line.substr(start, line.find_first_of(" \t\r", start) - start));
+        if (command == "load" || command == "attach" || command == "transcripts" || command == "version" ||
+            command == "add" || command == "remove" || command == "require" || command == "unrequire" ||
+            command == "compact") {
+            CourseSerializer::writeError(out, session.format, command + " is not available in server mode");
+            co_return false;
+        }
+        co_return co_await executeQuery(line, session, out, &scheduler);
+    }
+    
+    /**
+     * Execute one HTTP request and hand its response to the event loop
+     * @param fd Connection the request came from
+     * @param head Request line and headers
+     */
+    Task<void> serveHttp(int fd, string head) {
+        istringstream lines(head);
+        string requestLine, method, target, version;
+        getline(lines, requestLine);
+        istringstream(requestLine) >> method >> target >> version;
+        
+        bool close = version != "HTTP/1.1";
+        string header;
+        while (getline(lines, header)) {
+            string key = toLowerCase(header.substr(0, header.find(':')));
+            if (key != "connection") continue;
+            string value = toLowerCase(header.substr(header.find(':') + 1));
+            if (value.find("close") != string::npos) close = true;
+            if (value.find("keep-alive") != string::npos) close = false;
+        }
+        
+        CommandSession session;
+        session.format = OutputFormat::Json;
+        OutputBuffer body(-1);
+        const char* status = "200 OK";
+        
+        if (method != "GET") {
+            status = "405 Method Not Allowed";
+            CourseSerializer::writeError(body, session.format, "only GET is supported");
+        } else {
+            size_t queryStart = target.find('?');
+            string path = target.substr(0, queryStart);
+            string query = (queryStart == string::npos) ? "" : target.substr(queryStart + 1);
+            
+            size_t formatStart = query.find("format=");
+            if (formatStart != string::npos && (formatStart == 0 || query[formatStart - 1] == '&')) {
+                string name = query.substr(formatStart + 7, query.find('&', formatStart) - formatStart - 7);
+                parseOutputFormat(urlDecode(name), session.format);
+            }
+            
+            string command;
+            for (const string& segment : ::format(path, "/")) {
+                if (segment.empty()) continue;
+                command += (command.empty() ? "" : " ") + urlDecode(segment);
+            }
+            if (command.find('\n') != string::npos || toLowerCase(command.substr(0, 4)) == "quit") {
+                command = "#";
+            }
+            if (command.empty()) command = "list";
+            if (!co_await runCommand(command, session, body)) {
+                status = "400 Bad Request";
+            }
+        }
+        requestsServed++;
+        
+        static const char* CONTENT_TYPES[] = { "text/plain; charset=utf-8", "application/json",
+                                               "application/x-ndjson", "text/csv; charset=utf-8" };
+        OutputBuffer response(-1);
+        response.append("HTTP/1.1 ").append(status).append("\r\nContent-Type: ");
+        response.append(CONTENT_TYPES[(int)session.format]).append("\r\nContent-Length: ").appendNumber(body.size());
+        response.append(close ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+        response.append(body.data(), body.size());
+        complete(Completion{fd, string(response.data(), response.size()), CommandSession(), close});
+    }
+    
+    /**
+     * Hand the connection's next complete requests to a worker, if it is idle
+     * @param fd Connection to dispatch
+     */
+    void dispatch(int fd) {
+        Connection& connection = connections[fd];
+        if (connection.busy || connection.input.empty()) return;
+        
+        if (connection.sent == 0 && connection.output.empty() && !connection.http) {
+            static const char* METHODS[] = { "GET ", "HEAD ", "POST ", "PUT ", "DELETE ", "OPTIONS " };
+            for (const char* method : METHODS) {
+                connection.http |= connection.input.compare(0, strlen(method), method) == 0;
+            }
+        }
+        
+        if (connection.http) {
+            size_t end = connection.input.find("\r\n\r\n");
+            size_t separator = 4;
+            if (end == string::npos) {
+                end = connection.input.find("\n\n");
+                separator = 2;
+            }
+            if (end == string::npos) {
+                if (connection.input.size() > MAX_REQUEST) connection.closing = true;
+                return;
+            }
+            
+            string head = connection.input.substr(0, end);
+            connection.input.erase(0, end + separator);
+            connection.busy = true;
+            scheduler.spawn(serveHttp(fd, move(head)));
+            return;
+        }
+        
+        vector<string> lines;
+        size_t start = 0;
+        for (size_t end = connection.input.find('\n'); end != string::npos && lines.size() < MAX_LINES_PER_TASK;
+             end = connection.input.find('\n', start)) {
+            lines.push_back(connection.input.substr(start, end - start));
+            start = end + 1;
+        }
+        connection.input.erase(0, start);
+        if (lines.empty()) {
+            if (connection.input.size() > MAX_REQUEST) connection.closing = true;
+            return;
+        }
+        
+        connection.busy = true;
+        scheduler.spawn(serveLines(fd, move(lines), connection.session));
+    }
+    
+    /**
+     * Queue a finished response for the event loop and wake it
+     */
+    void complete(Completion done) {
+        {
+            lock_guard<mutex> guard(completedLock);
+            completed.push_back(move(done));
+        }
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+    
+    /**
+     * Send as much pending output as the socket accepts, watching for writability if some remains
+     * @param fd Connection to flush
+     */
+    void flushOutput(int fd) {
+        Connection& connection = connections[fd];
+        while (connection.sent < connection.output.size()) {
+            ssize_t result = send(fd, connection.output.data() + connection.sent,
+                                  connection.output.size() - connection.sent, MSG_NOSIGNAL);
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (result <= 0) {
+                // The peer is gone: drop everything still queued for it
+                connection.closing = true;
+                connection.input.clear();
+                connection.output.clear();
+                break;
+            }
+            connection.sent += result;
+        }
+        
+        if (connection.sent >= connection.output.size()) {
+            connection.output.clear();
+            connection.sent = 0;
+        }
+        updateEvents(fd);
+    }
+    
+    /**
+     * Close a connection once nothing is executing or waiting to be sent
+     * @param fd Connection to check
+     */
+    void closeIfDone(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection& connection = it->second;
+        if (!connection.closing || connection.busy || !connection.output.empty()) return;
+        
+        if (connection.registered) epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(it);
+    }
+    
+    /**
+     * Read everything available from a connection and dispatch complete requests
+     * @param fd Connection to read
+     */
+    void readInput(int fd) {
+        Connection& connection = connections[fd];
+        char chunk[64 * 1024];
+        while (true) {
+            ssize_t result = recv(fd, chunk, sizeof(chunk), 0);
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (result <= 0) {
+                connection.closing = true;
+                break;
+            }
+            connection.input.append(chunk, result);
+        }
+        
+        // A final command line may end at end of stream instead of a newline
+        if (connection.closing && !connection.http && !connection.input.empty() && connection.input.back() != '\n') {
+            connection.input += '\n';
+        }
+        dispatch(fd);
+        updateEvents(fd);
+    }
+    
+    /**
+     * Attach responses finished by workers to their connections
+     */
+    void drainCompletions() {
+        uint64_t count;
+        ssize_t ignored = ::read(wakeFd, &count, sizeof(count));
+        (void)ignored;
+        
+        vector<Completion> ready;
+        {
+            lock_guard<mutex> guard(completedLock);
+            ready.swap(completed);
+        }
+        for (Completion& done : ready) {
+            Connection& connection = connections[done.fd];
+            connection.busy = false;
+            connection.output += done.response;
+            if (!connection.http) connection.session = done.session;
+            if (done.close) {
+                connection.closing = true;
+                connection.input.clear();
+            }
+            
+            flushOutput(done.fd);
+            dispatch(done.fd);
+            closeIfDone(done.fd);
+        }
+    }
+    
+    /**
+     * Accept every pending connection
+     */
+    void acceptConnections() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            connections[fd] = Connection();
+            watch(fd, EPOLLIN | EPOLLRDHUP, true);
+        }
+    }
+    
+    /**
+     * Create the epoll instance and its wake-up and signal descriptors, and start listening
+     * @return false on failure
+     */
+    bool startLoop() {
+        if (listen(listenFd, SOMAXCONN) < 0) return false;
+        setNonBlocking(listenFd);
+        
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        signalFd = signalfd(-1, &shutdownSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0 || signalFd < 0) return false;
+        
+        watch(listenFd, EPOLLIN, true);
+        watch(wakeFd, EPOLLIN, true);
+        watch(signalFd, EPOLLIN, true);
+        return true;
+    }
+    
+public:
+    /**
+     * Create a server; call listenOn, then run
+     * @param threadCount Worker threads executing commands
+     */
+    explicit QueryServer(unsigned threadCount) : scheduler(threadCount) {}
+    
+    ~QueryServer() {
+        for (auto& entry : connections) close(entry.first);
+        for (int fd : {listenFd, epollFd, wakeFd, signalFd}) {
+            if (fd >= 0) close(fd);
+        }
+        if (!socketPath.empty()) unlink(socketPath.c_str());
+    }
+    
+    /**
+     * Bind to a Unix socket path, or to 127.0.0.1 if the address is a port number
+     * @param address Socket path or TCP port
+     * @return false if the socket could not be bound
+     */
+    bool listenOn(const string& address) {
+        if (!address.empty() && address.find_first_not_of("0123456789") == string::npos) {
+            listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            int reuse = 1;
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            
+            sockaddr_in bound = {};
+            bound.sin_family = AF_INET;
+            bound.sin_port = htons((uint16_t)stoi(address));
+            bound.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return listenFd >= 0 && bind(listenFd, (sockaddr*)&bound, sizeof(bound)) == 0 && startLoop();
+        }
+        
+        sockaddr_un bound = {};
+        if (address.size() >= sizeof(bound.sun_path)) return false;
+        bound.sun_family = AF_UNIX;
+        memcpy(bound.sun_path, address.data(), address.size());
+        
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        unlink(address.c_str());
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&bound, sizeof(bound)) != 0) return false;
+        socketPath = address;
+        return startLoop();
+    }
+    
+    /**
+     * Serve until SIGINT or SIGTERM
+     * @return Number of requests served
+     */
+    size_t run() {
+        epoll_event events[256];
+        bool stopping = false;
+        
+        while (!stopping) {
+            int count = epoll_wait(epollFd, events, 256, -1);
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0) break;
             
-            std::cout << "Data successfully loaded.\n" << endl;
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptConnections();
+                } else if (fd == wakeFd) {
+                    drainCompletions();
+                } else if (fd == signalFd) {
+                    stopping = true;
+                } else if (connections.count(fd)) {
+                    Connection& connection = connections[fd];
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        // Nothing more can be sent; stop watching so the hang-up is not reported again
+                        connection.closing = true;
+                        connection.input.clear();
+                        connection.output.clear();
+                        connection.sent = 0;
+                        connection.registered = false;
+                        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                    } else {
+                        if (events[i].events & (EPOLLIN | EPOLLRDHUP)) readInput(fd);
+                        if (events[i].events & EPOLLOUT) flushOutput(fd);
+                    }
+                    closeIfDone(fd);
+                }
+            }
+        }
+        
+        // Let in-flight requests finish so no worker touches a closed connection
+        while (any_of(connections.begin(), connections.end(), [](const pair<const int, Connection>& entry) {
+            return entry.second.busy;
+        })) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            lock_guard<mutex> guard(completedLock);
+            for (const Completion& done : completed) connections[done.fd].busy = false;
+            completed.clear();
+        }
+        return requestsServed;
+    }
+};
+
+
+/**
+ * Load a catalog and serve queries on it until interrupted
+ * @param address Unix socket path, or a localhost TCP port number
+ * @param path Courses file to load, unless a catalog image is already attached
+ * @return Process exit status
+ */
+int serveCatalog(const string& address, const string& path)
+{
+    if (!catalogImage.isAttached()) {
+        loadCatalog(path, cerr);
+        if (!dataLoaded) {
+            return 1;
+        }
+        warmCatalogCaches();
+    }
+    
+    QueryServer server(workerCount());
+    if (!server.listenOn(address)) {
+        cerr << "Could not listen on " << address << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    cerr << "Serving " << (catalogImage.isAttached() ? catalogImage.size() : courseHashTable.size())
+         << " courses on " << address << " with " << workerCount() << " worker thread(s)." << endl;
+    
+    size_t served = server.run();
+    cerr << "Served " << served << " requests." << endl;
+    return 0;
+}
+
+
+/**
+ * Load a courses file and publish it as a catalog image other processes can attach to
+ * @param name "/name" for a POSIX shared-memory object, otherwise a file path
+ * @param path Courses file to load
+ * @return Process exit status
+ */
+int publishCatalog(const string& name, const string& path)
+{
+    loadCatalog(path, cerr);
+    if (!dataLoaded) {
+        return 1;
+    }
+    warmCatalogCaches();
+    
+    size_t bytes = 0;
+    string error;
+    if (!CatalogImage::publish(name, courseHashTable, prereqGraph, catalogIndexes, bytes, error)) {
+        cerr << "Could not publish catalog to " << name << ": " << error << "." << endl;
+        return 1;
+    }
+    cerr << "Published " << courseHashTable.size() << " courses to " << name << " (" << (bytes + 1023) / 1024 << " KiB)." << endl;
+    return 0;
+}
+
+
+/**
+ * Append a length-prefixed string to a binary snapshot
+ * @param out Snapshot stream
+ * @param value String to write
+ */
+void writeSnapshotString(ostream& out, const string& value)
+{
+    uint32_t length = (uint32_t)value.size();
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(value.data(), value.size());
+}
+
+
+/**
+ * Append requirement groups to a binary snapshot: a group count, then each group
+ * as an alternative count followed by the course numbers
+ * @param out Snapshot stream
+ * @param groups Requirement groups to write
+ */
+void writeSnapshotGroups(ostream& out, const vector<vector<string>>& groups)
+{
+    uint32_t count = (uint32_t)groups.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const vector<string>& group : groups) {
+        uint32_t alternatives = (uint32_t)group.size();
+        out.write(reinterpret_cast<const char*>(&alternatives), sizeof(alternatives));
+        for (const string& courseNumber : group) {
+            writeSnapshotString(out, courseNumber);
+        }
+    }
+}
+
+
+/**
+ * Sort a courses file that may not fit in memory
+ *
+ * Without a snapshot path the sorted course list is printed exactly as option 2
+ * prints it. With one, a binary snapshot is written instead: the magic "CPSNAP01",
+ * then per course its number, name, prerequisite groups and co-requisite groups.
+ *
+ * @param inputPath Courses file to sort
+ * @param memoryBudget Approximate bytes of memory to use
+ * @param snapshotPath Binary snapshot to write, or empty to print the listing
+ * @return false if a file could not be read or written
+ */
+bool sortCoursesFileExternally(const string& inputPath, size_t memoryBudget, const string& snapshotPath)
+{
+    ifstream fin(inputPath, ios::in);
+    if (!fin) {
+        cout << "Could not access courses file. Please check if loaded properly." << endl;
+        return false;
+    }
+    
+    ofstream snapshot;
+    if (!snapshotPath.empty()) {
+        snapshot.open(snapshotPath, ios::out | ios::binary | ios::trunc);
+        if (!snapshot) {
+            cout << "Could not create snapshot " << snapshotPath << "." << endl;
+            return false;
+        }
+        snapshot.write("CPSNAP01", 8);
+    }
+    
+    OutputBuffer listing(snapshotPath.empty() ? STDOUT_FILENO : -1);
+    ExternalSort::Stats stats;
+    string error;
+    bool sorted = ExternalSort::sortLines(fin, memoryBudget, [&](const string& line) {
+        Course course = parseCourseLine(line);
+        if (snapshotPath.empty()) {
+            renderCourse(listing, course);
+            return;
+        }
+        writeSnapshotString(snapshot, course.courseNumber);
+        writeSnapshotString(snapshot, course.name);
+        writeSnapshotGroups(snapshot, course.prerequisiteGroups);
+        writeSnapshotGroups(snapshot, course.corequisiteGroups);
+    }, stats, error);
+    
+    if (!sorted) {
+        listing.flush();
+        cout << "Could not write temporary sort runs: " << error << ". Please check the temporary directory." << endl;
+        return false;
+    }
+    if (!snapshotPath.empty()) {
+        snapshot.close();
+        if (!snapshot) {
+            cout << "Could not write snapshot " << snapshotPath << "." << endl;
+            return false;
+        }
+        cout << "Sorted " << stats.lines << " courses using " << stats.runs << " run(s) and "
+             << stats.mergePasses << " merge pass(es) into " << snapshotPath << "." << endl;
+    }
+    return sorted;
+}
+
+/**
+ * Search for and display a specific course
+ *
+ * Enhancement: Hash table lookup O(1) instead of linear search O(n) for boosted performance
+ */
+void searchCourse()
+{
+    string courseNumber;
+    cout << "What course do you want to know about? ";
+    cin >> courseNumber;
+    cout << endl;
+    
+    if (!dataLoaded) {
+        cout << "Please load courses first." << endl;
+    }
+
+    Course* found = courseHashTable.find(courseNumber);
+    if (found) {
+        printCourse(*found);
+    } else {
+        cout << "Course " << courseNumber << " not found.\n" << endl;
+    }
+}
+
+
+/**
+ * Generate a synthetic catalog for benchmarks
+ *
+ * Courses are spread over departments of 200 courses and four levels. Most
+ * prerequisites come from lower levels of the same department, with an occasional
+ * prerequisite from the top level of the previous department chaining departments
+ * together. Courses are returned in shuffled order, so IDs
+ * assigned on insertion carry no locality.
+ *
+ * @param courseCount Number of courses to generate
+ * @param seed Random seed, so runs are repeatable
+ * @return Vector of generated courses
+ */
+vector<Course> generateSyntheticCatalog(size_t courseCount, unsigned seed = 42)
+{
+    const size_t DEPARTMENT_SIZE = 200;
+    mt19937 rng(seed);
+    vector<Course> courses(courseCount);
+    
+    auto numberOf = [&](size_t index) {
+        return "D" + to_string(index / DEPARTMENT_SIZE) + "_" + to_string(1000 + index % DEPARTMENT_SIZE);
+    };
+    
+    for (size_t i = 0; i < courseCount; i++) {
+        Course& course = courses[i];
+        course.courseNumber = numberOf(i);
+        course.name = "Synthetic Course " + to_string(i);
+        
+        size_t departmentStart = i - i % DEPARTMENT_SIZE;
+        size_t levelStart = departmentStart + (i % DEPARTMENT_SIZE) / (DEPARTMENT_SIZE / 4) * (DEPARTMENT_SIZE / 4);
+        if (levelStart == departmentStart) continue;
+        
+        int prereqCount = 1 + rng() % 3;
+        for (int p = 0; p < prereqCount; p++) {
+            size_t prereq = departmentStart + rng() % (levelStart - departmentStart);
+            if (rng() % 3 == 0 && departmentStart > 0) {
+                prereq = departmentStart - DEPARTMENT_SIZE / 4 + rng() % (DEPARTMENT_SIZE / 4);
+            }
+            course.prerequisites.push_back(numberOf(prereq));
+        }
+    }
+    
+    shuffle(courses.begin(), courses.end(), rng);
+    return courses;
+}
+
+
+/**
+ * Time a callable, returning the mean milliseconds per run
+ * @param runs Number of runs to average over
+ * @param body Callable to time
+ * @return Mean wall-clock milliseconds per run
+ */
+double timeMilliseconds(int runs, const function<void()>& body)
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        body();
+    }
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+
+/**
+ * Benchmark k-hop traversals before and after course ID reordering
+ *
+ * Runs the same set of unlimited dependents and ancestors queries on a synthetic
+ * catalog with insertion-order IDs, then after each reordering strategy.
+ *
+ * @param courseCount Number of synthetic courses
+ */
+void benchmarkReordering(size_t courseCount)
+{
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
+    // Entry-level courses of the first departments have the largest dependent sets
+    vector<string> sources;
+    for (size_t i = 0; i < 8; i++) {
+        size_t department = i % 4, offset = i / 4;
+        if (department * 200 + offset >= courseCount) continue; // 200 courses per synthetic department
+        sources.push_back("D" + to_string(department) + "_" + to_string(1000 + offset));
+    }
+    
+    cout << "Traversal benchmark: " << courseCount << " courses, " << sources.size()
+         << " sources, " << workerCount() << " worker thread(s)" << endl;
+    
+    const char* labels[] = { "insertion order", "reverse Cuthill-McKee", "department then level" };
+    for (int variant = 0; variant < 3; variant++) {
+        PrerequisiteGraph graph;
+        for (const Course& course : catalog) {
+            graph.addCourse(course);
+        }
+        if (variant == 1) graph.reorderCourseIds(ReorderStrategy::ReverseCuthillMcKee);
+        if (variant == 2) graph.reorderCourseIds(ReorderStrategy::DepartmentLevel);
+        graph.countWithinHops(sources[0], TraversalDirection::Dependents); // Build the CSR arrays outside the timing
+        
+        size_t reached = 0;
+        double milliseconds = timeMilliseconds(3, [&]() {
+            for (const string& source : sources) {
+                reached += graph.countWithinHops(source, TraversalDirection::Dependents);
+                reached += graph.countWithinHops(source, TraversalDirection::Ancestors);
+            }
+        });
+        
+        cout << "  " << labels[variant] << ": " << milliseconds << " ms per query set ("
+             << reached / 3 << " courses reached)" << endl;
+    }
+}
+
+
+/**
+ * Benchmark bulk eligibility for a synthetic student cohort
+ *
+ * Every student completes a random prefix of levels in a few departments, then
+ * the full students x courses eligibility matrix is computed.
+ *
+ * @param studentCount Number of synthetic students
+ */
+void benchmarkEligibility(size_t studentCount)
+{
+    const size_t COURSE_COUNT = 5000;
+    vector<Course> catalog = generateSyntheticCatalog(COURSE_COUNT);
+    PrerequisiteGraph graph;
+    for (const Course& course : catalog) {
+        graph.addCourse(course);
+    }
+    
+    mt19937 rng(7);
+    vector<CourseBitset> transcripts;
+    transcripts.reserve(studentCount);
+    for (size_t s = 0; s < studentCount; s++) {
+        CourseBitset transcript(graph.courseCount());
+        for (int d = 0; d < 3; d++) {
+            size_t department = rng() % (COURSE_COUNT / 200);
+            size_t completedCount = rng() % 120;
+            for (size_t c = 0; c < completedCount; c++) {
+                string number = "D" + to_string(department) + "_" + to_string(1000 + c);
+                transcript.set(graph.getCourseId(number));
+            }
         }
+        transcripts.push_back(move(transcript));
+    }
     
-    fin.close();
-    return courses;
+    EligibilityMatrix matrix;
+    double milliseconds = timeMilliseconds(3, [&]() {
+        matrix = graph.computeEligibilityMatrix(transcripts);
+    });
+    
+    size_t pairs = 0;
+    for (size_t id = 0; id < graph.courseCount(); id++) {
+        pairs += matrix.countEligible((int)id);
+    }
+    cout << "Eligibility benchmark: " << studentCount << " students x " << graph.courseCount() << " courses, "
+         << workerCount() << " worker thread(s)" << endl;
+    cout << "  " << milliseconds << " ms per matrix (" << pairs << " eligible pairs)" << endl;
 }
 
 
 /**
- * Print detailed information for a single course
- * @param course Course object to print
+ * Benchmark parallel merge sort scaling from one thread to workerCount()
+ *
+ * Sorts the same shuffled synthetic catalog with the sequential bottom-up sort
+ * and with parallelSort at doubling thread counts, checking each result matches.
+ *
+ * @param courseCount Number of synthetic courses
  */
-void printCourse(Course course)
+void benchmarkSortScaling(size_t courseCount)
 {
-    cout << course.courseNumber << ", " << course.name << endl;
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
+    vector<Course> expected = catalog;
+    MergeSort::bottomUpSort(expected);
     
-    if (course.prerequisites.size() == 0) {
-        cout << "No prerequisites\n" << endl;
-        return;
+    cout << "Sort scaling benchmark: " << courseCount << " courses" << endl;
+    
+    vector<Course> courses;
+    double baseline = 0;
+    for (int run = 0; run < 3; run++) {
+        courses = catalog;
+        baseline += timeMilliseconds(1, [&]() { MergeSort::bottomUpSort(courses); });
+    }
+    baseline /= 3;
+    cout << "  bottom-up (sequential): " << baseline << " ms" << endl;
+    
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < workerCount(); threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(workerCount());
+    
+    for (unsigned threads : threadCounts) {
+        double milliseconds = 0;
+        bool identical = true;
+        for (int run = 0; run < 3; run++) {
+            courses = catalog;
+            milliseconds += timeMilliseconds(1, [&]() { MergeSort::parallelSort(courses, threads); });
+            for (size_t i = 0; i < courses.size() && identical; i++) {
+                identical = courses[i].name == expected[i].name;
+            }
+        }
+        milliseconds /= 3;
+        cout << "  parallel, " << threads << " thread(s): " << milliseconds << " ms, speedup "
+             << baseline / milliseconds << (identical ? "" : " (MISMATCH)") << endl;
+    }
+}
+
+
+/**
+ * Benchmark MergeSort::sort against std::stable_sort and std::sort
+ *
+ * Integer keys are sorted in four distributions (random, already sorted, reversed
+ * and few unique values), then synthetic Courses are sorted by course number
+ * through a member-pointer projection. Every result is checked against
+ * std::stable_sort.
+ *
+ * @param keyCount Number of keys and courses to sort
+ */
+void benchmarkSortCompare(size_t keyCount)
+{
+    mt19937_64 rng(11);
+    vector<uint64_t> random(keyCount), fewUnique(keyCount);
+    for (size_t i = 0; i < keyCount; i++) {
+        random[i] = rng();
+        fewUnique[i] = rng() % 16;
     }
+    vector<uint64_t> ascending = random;
+    std::sort(ascending.begin(), ascending.end());
+    vector<uint64_t> descending(ascending.rbegin(), ascending.rend());
     
-    cout << "Prerequisites: ";
-    for (size_t i = 0; i < course.prerequisites.size(); ++i) {
-        std::cout << course.prerequisites[i];
+    const char* labels[] = { "random", "sorted", "reversed", "few unique" };
+    const vector<uint64_t>* inputs[] = { &random, &ascending, &descending, &fewUnique };
+    
+    cout << "Sort comparison benchmark: " << keyCount << " keys" << endl;
+    for (int variant = 0; variant < 4; variant++) {
+        vector<uint64_t> expected = *inputs[variant];
+        std::stable_sort(expected.begin(), expected.end());
         
-        // Print a comma after each prerequisite except for the last one
-        if (i < course.prerequisites.size() - 1) {
-            std::cout << ", ";
+        vector<uint64_t> keys;
+        double merge = 0, stable = 0, unstable = 0;
+        bool identical = true;
+        for (int run = 0; run < 3; run++) {
+            keys = *inputs[variant];
+            merge += timeMilliseconds(1, [&]() { MergeSort::sort(keys.begin(), keys.end()); });
+            identical = identical && keys == expected;
+            keys = *inputs[variant];
+            stable += timeMilliseconds(1, [&]() { std::stable_sort(keys.begin(), keys.end()); });
+            keys = *inputs[variant];
+            unstable += timeMilliseconds(1, [&]() { std::sort(keys.begin(), keys.end()); });
+        }
+        cout << "  " << labels[variant] << ": MergeSort::sort " << merge / 3 << " ms, std::stable_sort "
+             << stable / 3 << " ms, std::sort " << unstable / 3 << " ms" << (identical ? "" : " (MISMATCH)") << endl;
+    }
+    
+    vector<Course> catalog = generateSyntheticCatalog(keyCount);
+    vector<Course> expected = catalog;
+    std::stable_sort(expected.begin(), expected.end(), [](const Course& a, const Course& b) {
+        return a.courseNumber < b.courseNumber;
+    });
+    
+    vector<Course> courses;
+    double merge = 0, stable = 0;
+    bool identical = true;
+    for (int run = 0; run < 3; run++) {
+        courses = catalog;
+        merge += timeMilliseconds(1, [&]() {
+            MergeSort::sort(courses.begin(), courses.end(), less<>(), &Course::courseNumber);
+        });
+        for (size_t i = 0; i < courses.size() && identical; i++) {
+            identical = courses[i].name == expected[i].name;
         }
+        courses = catalog;
+        stable += timeMilliseconds(1, [&]() {
+            std::stable_sort(courses.begin(), courses.end(), [](const Course& a, const Course& b) {
+                return a.courseNumber < b.courseNumber;
+            });
+        });
     }
-    cout << "\n\n";
+    cout << "  courses by number: MergeSort::sort " << merge / 3 << " ms, std::stable_sort "
+         << stable / 3 << " ms" << (identical ? "" : " (MISMATCH)") << endl;
 }
 
 
 /**
- * Print all courses in alphabetical order (previously sorted in loadCoursesFile)
- * @param courses Vector of courses to print
+ * Benchmark serializing a synthetic catalog in each structured format
+ *
+ * Output goes to an in-memory buffer that is emptied every megabyte, so the
+ * figures measure formatting rather than the destination.
+ *
+ * @param courseCount Number of synthetic courses
  */
-void printCourseList(vector<Course> courses)
+void benchmarkSerialize(size_t courseCount)
 {
-    if (courses.empty()) {
-        cout << "No courses loaded. Please load data first.\n" << endl;
-        return;
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
+    const char* labels[] = { "text", "json", "ndjson", "csv" };
+    OutputFormat formats[] = { OutputFormat::Text, OutputFormat::Json, OutputFormat::Ndjson, OutputFormat::Csv };
+    
+    cout << "Serialize benchmark: " << courseCount << " courses" << endl;
+    OutputBuffer out(-1, 2 * 1024 * 1024);
+    for (int variant = 0; variant < 4; variant++) {
+        size_t bytes = 0;
+        double milliseconds = timeMilliseconds(3, [&]() {
+            bytes = 0;
+            CourseSerializer serializer(out, formats[variant], CourseSerializer::Records::Courses);
+            for (const Course& course : catalog) {
+                serializer.write(course);
+                if (out.size() >= 1024 * 1024) {
+                    bytes += out.size();
+                    out.clear();
+                }
+            }
+            serializer.finish();
+            bytes += out.size();
+            out.clear();
+        });
+        cout << "  " << labels[variant] << ": " << milliseconds << " ms, " << bytes / (1024 * 1024) << " MB, "
+             << bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0) << " MB/s" << endl;
+    }
+}
+
+
+/**
+ * Benchmark parallel rendering of a full course listing from one thread to workerCount()
+ *
+ * Each thread count renders the listing to /dev/null for timing, and once into
+ * memory to check the bytes match serial rendering. The list command is then run
+ * in JSON, NDJSON and CSV at each thread count and checked against one serializer
+ * writing the same courses serially.
+ *
+ * @param courseCount Number of synthetic courses
+ */
+void benchmarkRenderScaling(size_t courseCount)
+{
+    unsigned previousThreadCount = plannerThreadCount;
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
+    CourseHashTable table;
+    for (const Course& course : catalog) {
+        table.insert(course);
+    }
+    CourseOrdering courses = RadixSort::orderNaturally(table);
+    auto renderRange = [&](OutputBuffer& slice, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            renderCourse(slice, courses[i]);
+        }
+    };
+    
+    unsigned maxThreads = workerCount();
+    plannerThreadCount = 1;
+    OutputBuffer serial(-1);
+    renderParallel(serial, courses.size(), renderRange);
+    
+    int devNull = open("/dev/null", O_WRONLY);
+    cout << "Render scaling benchmark: " << courseCount << " courses, " << serial.size() / (1024 * 1024) << " MB" << endl;
+    
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+    
+    double baseline = 0;
+    for (unsigned threads : threadCounts) {
+        plannerThreadCount = threads;
+        OutputBuffer check(-1);
+        renderParallel(check, courses.size(), renderRange);
+        bool identical = check.size() == serial.size() && memcmp(check.data(), serial.data(), serial.size()) == 0;
+        
+        double milliseconds = timeMilliseconds(3, [&]() {
+            OutputBuffer out(devNull);
+            renderParallel(out, courses.size(), renderRange);
+        });
+        if (threads == 1) baseline = milliseconds;
+        cout << "  " << threads << " thread(s): " << milliseconds << " ms, speedup " << baseline / milliseconds
+             << (identical ? "" : " (MISMATCH)") << endl;
+    }
+    close(devNull);
+    
+    courseHashTable = CourseHashTable();
+    prereqGraph = PrerequisiteGraph();
+    catalogIndexes.invalidate();
+    for (const Course& course : catalog) {
+        courseHashTable.insert(course);
+        prereqGraph.addCourse(course);
+    }
+    dataLoaded = true;
+    CourseOrdering listed = getCatalogOrdering(CatalogOrder::Department);
+    
+    const OutputFormat formats[] = { OutputFormat::Json, OutputFormat::Ndjson, OutputFormat::Csv };
+    const char* labels[] = { "json", "ndjson", "csv" };
+    for (int variant = 0; variant < 3; variant++) {
+        OutputBuffer expected(-1);
+        CourseSerializer serializer(expected, formats[variant], CourseSerializer::Records::Courses);
+        for (size_t i = 0; i < listed.size(); i++) {
+            serializer.write(listed[i]);
+        }
+        serializer.finish();
+        
+        string mismatches;
+        for (unsigned threads : threadCounts) {
+            plannerThreadCount = threads;
+            CommandSession session;
+            session.format = formats[variant];
+            OutputBuffer out(-1);
+            executeCommand("list", session, out);
+            if (out.size() != expected.size() || memcmp(out.data(), expected.data(), expected.size()) != 0) {
+                mismatches += " " + to_string(threads);
+            }
+        }
+        cout << "  list as " << labels[variant] << ": "
+             << (mismatches.empty() ? "matches serial output" : "MISMATCH at thread count(s)" + mismatches) << endl;
+    }
+    plannerThreadCount = previousThreadCount;
+}
+
+
+/**
+ * Run full-catalog plans until told to stop, as background load for benchmarkMixedLoad
+ *
+ * Each plan goes to the back of the queue like a new request, so queued lookups
+ * run between plans even when the plans themselves never pause.
+ *
+ * @param scheduler Scheduler running the plans
+ * @param yielding Whether plans pause between slices
+ * @param stop Flag that ends the loop
+ * @param finished Incremented after each plan
+ * @param running Decremented when the loop ends
+ */
+Task<void> runBackgroundPlans(CoroutineScheduler& scheduler, bool yielding, atomic<bool>& stop,
+                              atomic<size_t>& finished, atomic<int>& running)
+{
+    const string plan = "plan";
+    CommandSession session;
+    while (!stop) {
+        OutputBuffer out(-1);
+        co_await executeQuery(plan, session, out, yielding ? &scheduler : nullptr);
+        finished++;
+        co_await scheduler.schedule();
+    }
+    running--;
+}
+
+
+/**
+ * Run one lookup and record how long it took from submission, for benchmarkMixedLoad
+ * @param line Lookup command
+ * @param submitted Time the lookup was handed to the scheduler
+ * @param latency Output: microseconds from submission to completion
+ * @param pending Decremented once the latency is recorded
+ */
+Task<void> timeLookup(string line, chrono::steady_clock::time_point submitted, double& latency, atomic<int>& pending)
+{
+    CommandSession session;
+    OutputBuffer out(-1);
+    co_await executeQuery(line, session, out, nullptr);
+    latency = chrono::duration<double, micro>(chrono::steady_clock::now() - submitted).count();
+    pending--;
+}
+
+
+/**
+ * Benchmark lookup latency while long-running queries keep every worker busy
+ *
+ * Loads a synthetic catalog, keeps one full-catalog plan per worker thread
+ * running on a CoroutineScheduler, and submits lookups alongside them at a
+ * steady rate: first with the plans yielding every thousand or so courses, then
+ * with each plan running to completion before its thread takes other work.
+ *
+ * @param courseCount Number of synthetic courses
+ */
+void benchmarkMixedLoad(size_t courseCount)
+{
+    const int LOOKUPS = 500;
+    
+    courseHashTable = CourseHashTable();
+    prereqGraph = PrerequisiteGraph();
+    catalogIndexes.invalidate();
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
+    for (const Course& course : catalog) {
+        courseHashTable.insert(course);
+        prereqGraph.addCourse(course);
     }
+    dataLoaded = true;
+    warmCatalogCaches();
     
-    for(Course course: courses)
+    // Each query stays on its scheduler thread, so the threads are the only parallelism
+    unsigned threads = workerCount();
+    unsigned previousThreadCount = plannerThreadCount;
+    plannerThreadCount = 1;
+    cout << "Mixed load benchmark: " << courseCount << " courses, " << threads << " scheduler thread(s), "
+         << LOOKUPS << " lookups" << endl;
+    
+    for (bool yielding : {true, false}) {
+        vector<double> latencies(LOOKUPS);
+        atomic<bool> stop{false};
+        atomic<size_t> plansFinished{0};
+        atomic<int> running{(int)threads};
+        atomic<int> pending{LOOKUPS};
+        auto start = chrono::steady_clock::now();
+        {
+            CoroutineScheduler scheduler(threads);
+            for (unsigned t = 0; t < threads; t++) {
+                scheduler.spawn(runBackgroundPlans(scheduler, yielding, stop, plansFinished, running));
+            }
+            for (int i = 0; i < LOOKUPS; i++) {
+                this_thread::sleep_for(chrono::milliseconds(2));
+                string line = "lookup " + catalog[(i * 7919) % catalog.size()].courseNumber;
+                scheduler.spawn(timeLookup(line, chrono::steady_clock::now(), latencies[i], pending));
+            }
+            while (pending > 0) {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            stop = true;
+            while (running > 0) {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        
+        sort(latencies.begin(), latencies.end());
+        cout << "  " << (yielding ? "yielding plans:   " : "unyielding plans: ") << "lookup p50 "
+             << latencies[LOOKUPS / 2] << " us, p99 " << latencies[LOOKUPS * 99 / 100] << " us, max "
+             << latencies.back() << " us; " << plansFinished / elapsed.count() << " plans/s" << endl;
+    }
+    plannerThreadCount = previousThreadCount;
+}
+
+
+/**
+ * Get the resident memory of this process
+ * @return Resident set size in KiB, 0 if unavailable
+ */
+size_t residentKilobytes()
+{
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (size_t)sysconf(_SC_PAGESIZE) / 1024;
+}
+
+
+/**
+ * Benchmark startup from a courses file against attaching to a published image
+ *
+ * Times what every worker process pays today (parse the file and build the
+ * catalog structures) against attaching to an image in POSIX shared memory, then
+ * runs the same lookups and traversals both ways and checks their output matches.
+ *
+ * @param courseCount Number of synthetic courses
+ */
+void benchmarkSharedCatalog(size_t courseCount)
+{
+    string coursesPath = "/tmp/planner-bench-" + to_string(getpid()) + ".txt";
+    string imageName = "/planner-bench-" + to_string(getpid());
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
     {
-        printCourse(course);
+        ofstream file(coursesPath);
+        for (const Course& course : catalog) {
+            file << course.courseNumber << "," << course.name;
+            for (const string& prerequisite : course.prerequisites) file << "," << prerequisite;
+            file << "\n";
+        }
+    }
+    
+    cout << "Shared catalog benchmark: " << courseCount << " courses" << endl;
+    ostringstream messages;
+    size_t residentBefore = residentKilobytes();
+    double loadMilliseconds = timeMilliseconds(1, [&]() {
+        loadCoursesFile(coursesPath, messages);
+        warmCatalogCaches();
+    });
+    size_t residentLoaded = residentKilobytes();
+    cout << "  load and build: " << loadMilliseconds << " ms, +" << (residentLoaded - min(residentBefore, residentLoaded)) / 1024
+         << " MB resident" << endl;
+    
+    size_t bytes = 0;
+    string error;
+    double publishMilliseconds = timeMilliseconds(1, [&]() {
+        if (!CatalogImage::publish(imageName, courseHashTable, prereqGraph, catalogIndexes, bytes, error)) {
+            cout << "  publish failed: " << error << endl;
+        }
+    });
+    cout << "  publish: " << publishMilliseconds << " ms, " << bytes / (1024 * 1024) << " MB image" << endl;
+    
+    // The same queries against the loaded catalog and the attached image
+    vector<string> commands;
+    mt19937 rng(7);
+    for (int i = 0; i < 2000; i++) {
+        commands.push_back("lookup " + catalog[rng() % catalog.size()].courseNumber);
+    }
+    for (int i = 0; i < 20; i++) {
+        commands.push_back("dependents " + catalog[rng() % catalog.size()].courseNumber);
+        commands.push_back("plan " + catalog[rng() % catalog.size()].courseNumber);
     }
+    auto runCommands = [&](string& output) {
+        CommandSession session;
+        OutputBuffer out(-1);
+        output.clear();
+        return timeMilliseconds(1, [&]() {
+            for (const string& command : commands) {
+                executeCommand(command, session, out);
+                output.append(out.data(), out.size());
+                out.clear();
+            }
+        });
+    };
+    string loadedOutput, attachedOutput;
+    double loadedQueries = runCommands(loadedOutput);
+    
+    // Attaching once releases the loaded catalog, so later attaches time only the mapping
+    attachCatalogImage(imageName, messages);
+    double attachMilliseconds = timeMilliseconds(100, [&]() {
+        catalogImage.attach(imageName, error);
+    });
+    cout << "  attach: " << attachMilliseconds << " ms" << endl;
+    if (catalogImage.isAttached()) {
+        double attachedQueries = runCommands(attachedOutput);
+        cout << "  " << commands.size() << " queries: loaded " << loadedQueries << " ms, attached " << attachedQueries
+             << " ms, output " << (loadedOutput == attachedOutput ? "matches" : "DIFFERS") << endl;
+    }
+    
+    catalogImage.detach();
+    CatalogImage::unpublish(imageName);
+    remove(coursesPath.c_str());
 }
 
+
 /**
- * Search for and display a specific course
+ * Benchmark transcript ingest and bulk degree audits
  *
- * Enhancement: Hash table lookup O(1) instead of linear search O(n) for boosted performance
+ * Streams synthetic transcripts from CSV into a TranscriptStore, then audits
+ * every student against course, credit and prerequisite rules on all worker
+ * threads. Each student works through the levels of three departments, a few
+ * courses a term, failing and retaking the odd course.
+ *
+ * @param studentCount Number of synthetic students
  */
-void searchCourse()
+void benchmarkAudit(size_t studentCount)
 {
-    string courseNumber;
-    cout << "What course do you want to know about? ";
-    cin >> courseNumber;
-    cout << endl;
+    const size_t COURSE_COUNT = 5000;
+    const size_t DEPARTMENT_SIZE = 200;
+    vector<Course> catalog = generateSyntheticCatalog(COURSE_COUNT);
+    PrerequisiteGraph graph;
+    for (const Course& course : catalog) {
+        graph.addCourse(course);
+    }
     
-    if (!dataLoaded) {
-        cout << "Please load courses first." << endl;
+    string csv = "student,course,term,grade,credits\n";
+    mt19937 rng(11);
+    const char* grades[] = { "A", "A-", "B+", "B", "C", "D", "F", "P", "W" };
+    for (size_t s = 0; s < studentCount; s++) {
+        string student = "S" + to_string(1000000 + s);
+        int term = 0, inTerm = 0;
+        for (int d = 0; d < 3; d++) {
+            size_t department = rng() % (COURSE_COUNT / DEPARTMENT_SIZE);
+            size_t taken = 5 + rng() % 20;
+            for (size_t c = 0; c < taken; c++) {
+                csv += student + ",D" + to_string(department) + "_" + to_string(1000 + c * 4) + ",";
+                csv += to_string(2020 + term / 2) + "-" + to_string(1 + term % 2) + ",";
+                csv += grades[rng() % 9];
+                csv += "," + to_string(3 + rng() % 2) + "\n";
+                if (++inTerm == 5) {
+                    term++;
+                    inTerm = 0;
+                }
+            }
+        }
     }
+    
+    istringstream rulesFile("major: 6 of D0_1000 D0_1004 D0_1008 D0_1012 D0_1016 D1_1000 D1_1004 D1_1008 D1_1012 D1_1016\n"
+                            "core: all D0_1000 D0_1004\n"
+                            "upper: credits 30 D0 D1 D2 D3\n"
+                            "total: credits 90\n"
+                            "order: prerequisites\n");
+    vector<AuditRule> rules;
+    string error;
+    DegreeAudit::parseRules(rulesFile, rules, error);
+    
+    TranscriptStore store;
+    istringstream in(csv);
+    double ingestMilliseconds = timeMilliseconds(1, [&]() {
+        store.read(in, error);
+    });
+    cout << "Audit benchmark: " << store.studentCount() << " students, " << store.rowCount() << " transcript rows, "
+         << workerCount() << " worker thread(s)" << endl;
+    cout << "  ingest: " << ingestMilliseconds << " ms (" << (size_t)(store.rowCount() / ingestMilliseconds * 1000)
+         << " rows/s), " << (double)store.columnBytes() / store.rowCount() << " column bytes per row" << endl;
+    
+    DegreeAudit audit(store, rules, [&](const string& courseNumber) { return graph.getCourseId(courseNumber); },
+                      graph.requirementPrograms());
+    atomic<size_t> complete(0);
+    double auditMilliseconds = timeMilliseconds(3, [&]() {
+        complete = 0;
+        parallelFor(store.studentCount(), [&](size_t begin, size_t end, int) {
+            DegreeAudit::Scratch scratch(audit);
+            vector<string> unmet;
+            size_t passed = 0;
+            for (size_t s = begin; s < end; s++) {
+                passed += audit.audit((uint32_t)s, scratch, unmet);
+            }
+            complete += passed;
+        });
+    });
+    cout << "  audit: " << auditMilliseconds << " ms (" << (size_t)(store.studentCount() / auditMilliseconds * 1000)
+         << " students/s, " << complete << " complete)" << endl;
+}
 
-    Course* found = courseHashTable.find(courseNumber);
-    if (found) {
-        printCourse(*found);
-    } else {
-        cout << "Course " << courseNumber << " not found.\n" << endl;
+
+/**
+ * Benchmark term catalog versions
+ *
+ * Commits a synthetic catalog for a run of terms, each renaming, rewiring,
+ * adding and dropping about one course in two hundred, then reports how much of
+ * the catalog the versions share, and lookup and eligibility times as of random
+ * terms. Lookups are checked against each term's own course list.
+ *
+ * @param courseCount Number of synthetic courses in the first term
+ */
+void benchmarkVersions(size_t courseCount)
+{
+    const int TERMS = 12;
+    vector<Course> catalog = generateSyntheticCatalog(courseCount);
+    vector<vector<Course>> terms;
+    mt19937 rng(13);
+    for (int t = 0; t < TERMS; t++) {
+        if (t > 0) {
+            for (size_t c = 0; c < catalog.size() / 200; c++) {
+                Course& course = catalog[rng() % catalog.size()];
+                if (rng() % 2) course.name += " (revised)";
+                else if (!course.prerequisites.empty()) course.prerequisites.pop_back();
+            }
+            for (size_t c = 0; c < catalog.size() / 200; c++) {
+                catalog[rng() % catalog.size()] = catalog.back();
+                catalog.pop_back();
+            }
+            for (size_t c = 0; c < courseCount / 200; c++) {
+                Course course;
+                course.courseNumber = "T" + to_string(t) + "_" + to_string(1000 + c);
+                course.name = "New Course " + to_string(c);
+                course.prerequisites.push_back(catalog[rng() % catalog.size()].courseNumber);
+                catalog.push_back(course);
+            }
+        }
+        terms.push_back(catalog);
+    }
+    vector<string> termNames;
+    for (int t = 0; t < TERMS; t++) {
+        termNames.push_back(to_string(2020 + t / 2) + "-" + to_string(1 + t % 2));
+    }
+    
+    cout << "Versions benchmark: " << TERMS << " terms of about " << courseCount << " courses" << endl;
+    CatalogVersions versions;
+    size_t changes = 0;
+    double commitMilliseconds = timeMilliseconds(1, [&]() {
+        for (int t = 0; t < TERMS; t++) {
+            CatalogVersions::CommitStats stats = versions.commit(termNames[t], terms[t]);
+            if (t > 0) changes += stats.added + stats.changed + stats.removed;
+        }
+    });
+    CatalogVersions::SharingStats sharing = versions.sharingStats();
+    cout << "  commit: " << commitMilliseconds / TERMS << " ms per term, " << changes / (TERMS - 1)
+         << " courses changed per term" << endl;
+    cout << "  stored: " << sharing.records << " course records and " << sharing.nodes << " trie nodes for "
+         << sharing.courseEntries << " courses across versions (" << (double)sharing.courseEntries / sharing.records
+         << "x sharing)" << endl;
+    
+    const int LOOKUPS = 1000000;
+    size_t found = 0, mismatches = 0;
+    double lookupMilliseconds = timeMilliseconds(1, [&]() {
+        for (int i = 0; i < LOOKUPS; i++) {
+            int t = rng() % TERMS;
+            const Course& expected = terms[t][rng() % terms[t].size()];
+            const Course* course = versions.find(termNames[t], expected.courseNumber);
+            found += course != nullptr;
+            mismatches += !course || course->name != expected.name || course->prerequisites != expected.prerequisites;
+        }
+    });
+    cout << "  lookup: " << lookupMilliseconds * 1000000 / LOOKUPS << " ns as of a random term (" << found
+         << " found, " << mismatches << " mismatched)" << endl;
+    
+    vector<string> completed;
+    for (int i = 0; i < 40; i++) {
+        completed.push_back(catalog[rng() % catalog.size()].courseNumber);
+    }
+    size_t eligible = 0;
+    double eligibleMilliseconds = timeMilliseconds(TERMS, [&]() {
+        eligible += versions.findEligibleCourses(termNames[rng() % TERMS], completed, {}).size();
+    });
+    cout << "  eligible: " << eligibleMilliseconds << " ms per query as of a random term (" << eligible / TERMS
+         << " courses)" << endl;
+}
+
+
+/**
+ * Benchmark the catalog edit log
+ *
+ * Loads a synthetic catalog, then times edits committed in groups as batch mode
+ * does, and edits each synced alone, letting compaction fold the log into the
+ * courses file in the background. The catalog is then reloaded from the file and
+ * its log, and checked against the one in memory.
+ *
+ * @param editCount Number of edits to make
+ */
+void benchmarkEditLog(size_t editCount)
+{
+    const size_t COURSE_COUNT = 200000;
+    const size_t GROUP = 1000; // Edits per group commit
+    string coursesPath = "/tmp/planner-bench-" + to_string(getpid()) + ".txt";
+    vector<Course> catalog = generateSyntheticCatalog(COURSE_COUNT);
+    {
+        ofstream file(coursesPath);
+        for (const Course& course : catalog) {
+            file << formatCourseLine(course) << "\n";
+        }
+    }
+    ostringstream messages;
+    loadCatalog(coursesPath, messages);
+    
+    // New courses on top of existing ones, renamed courses and removals
+    mt19937 rng(17);
+    vector<string> edits;
+    for (size_t i = 0; i < editCount; i++) {
+        const Course& course = catalog[rng() % catalog.size()];
+        switch (rng() % 4) {
+            case 0: edits.push_back("remove " + course.courseNumber); break;
+            case 1: edits.push_back("add " + course.courseNumber + ",Renamed Course " + to_string(i)); break;
+            default: edits.push_back("add E" + to_string(i) + ",Elective " + to_string(i) + "," + course.courseNumber);
+        }
+    }
+    
+    cout << "Edit log benchmark: " << editCount << " edits on " << COURSE_COUNT << " courses" << endl;
+    CommandSession session;
+    OutputBuffer out(-1);
+    size_t applied = 0, syncs = 0;
+    string error;
+    double groupedMilliseconds = timeMilliseconds(1, [&]() {
+        for (size_t i = 0; i < edits.size(); i++) {
+            applied += executeCommand(edits[i], session, out);
+            if ((i + 1) % GROUP == 0 || i + 1 == edits.size()) {
+                syncEditLog(session, out, error);
+                out.clear();
+                syncs++;
+            }
+        }
+    });
+    cout << "  group commit: " << (size_t)(editCount / groupedMilliseconds * 1000) << " edits/s (" << applied
+         << " applied, " << syncs << " syncs)" << endl;
+    
+    const size_t SINGLE = min<size_t>(editCount, 500);
+    double singleMilliseconds = timeMilliseconds(1, [&]() {
+        for (size_t i = 0; i < SINGLE; i++) {
+            executeCommand("add S" + to_string(i) + ",Seminar " + to_string(i), session, out);
+            syncEditLog(session, out, error);
+            out.clear();
+        }
+    });
+    cout << "  sync per edit: " << (size_t)(SINGLE / singleMilliseconds * 1000) << " edits/s" << endl;
+    
+    error = catalogLog.waitForCompaction();
+    if (!error.empty()) cout << "  compaction failed: " << error << endl;
+    struct stat logStat {}, coursesStat {};
+    stat((coursesPath + ".log").c_str(), &logStat);
+    stat(coursesPath.c_str(), &coursesStat);
+    cout << "  files: " << coursesStat.st_size / 1024 << " KiB courses file, " << logStat.st_size / 1024
+         << " KiB log after background compaction" << endl;
+    string expected = formatCatalogSnapshot();
+    double reloadMilliseconds = timeMilliseconds(1, [&]() {
+        loadCatalog(coursesPath, messages);
+    });
+    cout << "  reload with replay: " << reloadMilliseconds << " ms, catalog "
+         << (formatCatalogSnapshot() == expected ? "matches" : "DIFFERS") << endl;
+    
+    catalogLog.close();
+    remove(coursesPath.c_str());
+    remove((coursesPath + ".log").c_str());
+}
+
+
+/**
+ * Run a named benchmark
+ * @param name Benchmark to run ("reorder", "eligibility", "sort-scaling", "sort-compare", "serialize",
+ *             "render-scaling", "mixed-load", "shared-catalog", "audit", "versions", "edit-log")
+ * @param size Problem size, 0 for the benchmark's default
+ * @return false if the benchmark name is unknown
+ */
+bool runBenchmark(const string& name, size_t size)
+{
+    if (name == "reorder") {
+        benchmarkReordering(size > 0 ? size : 1000000);
+        return true;
+    }
+    if (name == "eligibility") {
+        benchmarkEligibility(size > 0 ? size : 100000);
+        return true;
+    }
+    if (name == "sort-scaling") {
+        benchmarkSortScaling(size > 0 ? size : 1000000);
+        return true;
     }
+    if (name == "sort-compare") {
+        benchmarkSortCompare(size > 0 ? size : 1000000);
+        return true;
+    }
+    if (name == "serialize") {
+        benchmarkSerialize(size > 0 ? size : 1000000);
+        return true;
+    }
+    if (name == "render-scaling") {
+        benchmarkRenderScaling(size > 0 ? size : 1000000);
+        return true;
+    }
+    if (name == "mixed-load") {
+        benchmarkMixedLoad(size > 0 ? size : 200000);
+        return true;
+    }
+    if (name == "shared-catalog") {
+        benchmarkSharedCatalog(size > 0 ? size : 200000);
+        return true;
+    }
+    if (name == "audit") {
+        benchmarkAudit(size > 0 ? size : 200000);
+        return true;
+    }
+    if (name == "versions") {
+        benchmarkVersions(size > 0 ? size : 200000);
+        return true;
+    }
+    if (name == "edit-log") {
+        benchmarkEditLog(size > 0 ? size : 300000);
+        return true;
+    }
+    
+    cout << "Unknown benchmark " << name << "." << endl;
+    return false;
 }
 
 
@@ -474,10 +9989,109 @@ void searchCourse()
  * 2. Print Course List - Prints sorted courses along with prerequisites
  * 3. Print Course - Uses hash table lookup to search for and print a specific course number and prerequisites
  * 4. Exit - Terminates the program
+ *
+ * Command Line:
+ * --benchmark <name> [size] [threads] - Run a benchmark instead of the menu
+ * --external-sort <file> [memoryMB] [snapshot] - Sort a courses file larger than memory
+ * --export <format> <command> [arguments] - Run one batch command on courses.txt in the
+ *   given format (text, json, ndjson or csv)
+ * --batch [file] - Run batch commands from a file, or from stdin
+ * --serve <socket path | port> [file] - Load a courses file once and serve batch commands
+ *   over a Unix socket or localhost TCP port, as lines or HTTP GET requests
+ * --publish <name> [file] - Load a courses file and publish it as a shared catalog image,
+ *   in POSIX shared memory for "/name" or in a file for any other path
+ * --unpublish <name> - Remove a published catalog image
+ * --attach <name> <--export | --serve | --batch> ... - Run one of those modes against a
+ *   published catalog image instead of loading courses.txt
  */
-int main()
+int main(int argc, char* argv[])
 {
-    vector<Course> courses;
+    CourseOrdering courses;
+    
+    if (argc > 2 && string(argv[1]) == "--benchmark") {
+        size_t size = 0, threads = 0;
+        if ((argc > 3 && !parseCount(argv[3], size)) || (argc > 4 && !parseCount(argv[4], threads))) {
+            cerr << "Usage: --benchmark <name> [size] [threads]" << endl;
+            return 1;
+        }
+        plannerThreadCount = (unsigned)threads;
+        return runBenchmark(argv[2], size) ? 0 : 1;
+    }
+    if (argc > 2 && string(argv[1]) == "--external-sort") {
+        double megabytes = 64;
+        if (argc > 3) {
+            char* end = nullptr;
+            megabytes = strtod(argv[3], &end);
+            if (end == argv[3] || *end != '\0' || !(megabytes > 0) || megabytes > 1024 * 1024) {
+                cerr << "Usage: --external-sort <file> [memoryMB] [snapshot]" << endl;
+                return 1;
+            }
+        }
+        string snapshotPath = (argc > 4) ? argv[4] : "";
+        return sortCoursesFileExternally(argv[2], (size_t)(megabytes * 1024 * 1024), snapshotPath) ? 0 : 1;
+    }
+    if (argc > 2 && string(argv[1]) == "--publish") {
+        return publishCatalog(argv[2], (argc > 3) ? argv[3] : "courses.txt");
+    }
+    if (argc > 2 && string(argv[1]) == "--unpublish") {
+        if (!CatalogImage::unpublish(argv[2])) {
+            cerr << "Could not remove catalog " << argv[2] << ": " << strerror(errno) << "." << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > 3 && string(argv[1]) == "--attach") {
+        string mode = argv[3];
+        if (mode != "--export" && mode != "--serve" && mode != "--batch") {
+            cerr << "--attach must be followed by --export, --serve or --batch." << endl;
+            return 1;
+        }
+        if (!attachCatalogImage(argv[2], cerr)) {
+            return 1;
+        }
+        // Continue as if the mode had been given first
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc > 2 && string(argv[1]) == "--export") {
+        OutputFormat format;
+        if (!parseOutputFormat(argv[2], format)) {
+            cerr << "Unknown output format " << argv[2] << "." << endl;
+            return 1;
+        }
+        string command = (argc > 3) ? argv[3] : "list";
+        for (int i = 4; i < argc; i++) {
+            command += string(" ") + argv[i];
+        }
+        
+        CommandSession session;
+        session.format = format;
+        if (!catalogImage.isAttached()) {
+            loadCatalog("courses.txt", cerr);
+            if (!dataLoaded) return 1;
+        }
+        OutputBuffer out(STDOUT_FILENO);
+        bool ok = executeCommand(command, session, out);
+        string error;
+        ok = syncEditLog(session, out, error) && ok;
+        return ok ? 0 : 1;
+    }
+    if (argc > 2 && string(argv[1]) == "--serve") {
+        plannerThreadCount = 0;
+        return serveCatalog(argv[2], (argc > 3) ? argv[3] : "courses.txt");
+    }
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        if (argc > 2) {
+            ifstream commands(argv[2]);
+            if (!commands) {
+                cerr << "Could not open command file " << argv[2] << "." << endl;
+                return 1;
+            }
+            return runBatch(commands) == 0 ? 0 : 1;
+        }
+        ios::sync_with_stdio(false);
+        return runBatch(cin) == 0 ? 0 : 1;
+    }
 
     cout << "Welcome to the course planner." << endl;
     cout << endl;
@@ -500,7 +10114,7 @@ int main()
         }
         else if (input == 1)
         {
-            courses = loadCoursesFile();
+            courses = loadCatalog("courses.txt", cout);
         }
         else if (input == 2)
         {